@@ -1,21 +1,46 @@
 #pragma once
 
+#include "Tecs_checkpoint.hh"
+#include "Tecs_component_pool.hh"
+#include "Tecs_cursor.hh"
+#include "Tecs_dynamic_component.hh"
 #include "Tecs_entity.hh"
+#include "Tecs_flyweight.hh"
 #include "Tecs_lock.hh"
 #include "Tecs_permissions.hh"
+#include "Tecs_stats.hh"
 #include "Tecs_storage.hh"
 #ifdef TECS_ENABLE_PERFORMANCE_TRACING
     #include "Tecs_tracing.hh"
 #endif
 
+#include <algorithm>
+#include <atomic>
 #include <bitset>
 #include <cstddef>
+#include <cstdint>
 #include <deque>
+#include <iterator>
+#include <memory>
+#include <string>
 #include <tuple>
 #include <type_traits>
 #include <vector>
 
 namespace Tecs {
+    /**
+     * Per-entity metadata for an ECS with N - 1 component types. Bit 0 is set if the entity exists, and bit 1 + i is
+     * set if the entity has the i-th component.
+     */
+    template<size_t N>
+    struct EntityMetadata : public std::bitset<N> {
+        TECS_ENTITY_GENERATION_TYPE generation = 0;
+    };
+
+    // Entity metadata is always write tracked, so that aborting an AddRemove transaction only resets modified entities.
+    template<size_t N>
+    struct is_write_tracked<EntityMetadata<N>> : std::true_type {};
+
     /**
      * An ECS "world" is created by instantiating this class. Component types must be known at compile-time and are
      * passed in as template arguments.
@@ -44,6 +69,7 @@ namespace Tecs {
          * Tecs::ReadAll                 - Allow read-only access to all existing Components
          * Tecs::Write<Components...>    - Allow write access to a list of Component types (existing Components only)
          * Tecs::WriteAll                - Allow write access to all existing Components
+         * Tecs::WriteDeferred<Comps...> - Allow write access to a list of Component types, without committing changes
          * Tecs::AddRemove               - Allow the creation and deletion of new Entities and Components
          *
          * It is recommended to start transactions with the minimum required permissions to prevent unnecessary thread
@@ -57,6 +83,137 @@ namespace Tecs {
             return Lock<ECS<Tn...>, Permissions...>(*this);
         }
 
+        /**
+         * Start a new transaction with permissions chosen at runtime, and return a DynamicLock object.
+         *
+         * Bit 1 + GetComponentIndex<T>() of each bitset requests read or write access to component T, and bit 0 of
+         * writePermissions requests AddRemove permissions, which also allows writing to all components. Write access
+         * implies read access. DynamicLock<ECS>::generateReadBitset<LockType>() and generateWriteBitset<LockType>()
+         * return the bitsets matching a static Lock type.
+         *
+         * Only the requested components are locked. Data is accessed by requesting a static Lock from the returned
+         * DynamicLock with TryLock<Permissions...>(), which checks the requested permissions at runtime.
+         */
+        inline DynamicLock<ECS<Tn...>> StartTransaction(std::bitset<1 + sizeof...(Tn)> readPermissions,
+            std::bitset<1 + sizeof...(Tn)> writePermissions) {
+            if (writePermissions[0]) writePermissions.set();
+            readPermissions |= writePermissions;
+            readPermissions[0] = true;
+            auto base = std::make_shared<DynamicTransaction<ECS, Tn...>>(*this, readPermissions, writePermissions);
+            return DynamicLock<ECS<Tn...>>(*this, base, readPermissions, writePermissions);
+        }
+
+        /**
+         * Commit any deferred writes made by WriteDeferred<Un...> transactions, making them visible to readers.
+         *
+         * Multiple WriteDeferred transactions can be run on the same Component types, with each transaction seeing the
+         * changes made by the previous ones. Only a single commit is then required when publishing all the changes.
+         * Writes made by a regular Write or AddRemove transaction also publish any deferred writes for the same types.
+         */
+        template<typename... Un>
+        inline void Publish() {
+            auto lock = StartTransaction<Write<Un...>>();
+            (lock.base->template SetAccessFlag<Un>(Storage<Un>().unpublished), ...);
+        }
+
+        /**
+         * Copy all committed entities and components into a new WorldCheckpoint, which can later be passed to
+         * Restore() to roll the instance back to this point.
+         */
+        inline WorldCheckpoint<ECS<Tn...>> Checkpoint() {
+            WorldCheckpoint<ECS<Tn...>> checkpoint;
+            Checkpoint(checkpoint);
+            return checkpoint;
+        }
+
+        /**
+         * Update an existing checkpoint to match the currently committed state, reusing its allocations.
+         * Only component types that have been committed since the checkpoint was last updated are copied.
+         */
+        inline void Checkpoint(WorldCheckpoint<ECS<Tn...>> &checkpoint) {
+            auto lock = StartTransaction<ReadAll>();
+            if (checkpoint.instance != this) {
+                checkpoint.instance = this;
+                checkpoint.commitCounts.fill(SIZE_MAX);
+            }
+            if (checkpoint.commitCounts[0] != metadata.commitCount) {
+                checkpoint.metadata = metadata.readComponents;
+                checkpoint.globalMetadata = globalReadMetadata;
+                checkpoint.commitCounts[0] = metadata.commitCount;
+            }
+            (CheckpointComponents<Tn>(checkpoint), ...);
+        }
+
+        /**
+         * Roll back all entities and components to the state stored in a checkpoint, in a single AddRemove
+         * transaction. Component types that haven't been committed since the checkpoint was created are not copied,
+         * unless they have unpublished WriteDeferred changes, which are discarded.
+         *
+         * Entities that exist in the checkpoint are restored with their original ids, and entities created after the
+         * checkpoint was made are removed. Entity generations are never rewound, so ids of removed entities are never
+         * reused, and an entity whose index was reused by another entity since the checkpoint is restored with a new
+         * generation. Observers receive ADDED and REMOVED events for all restored or removed
+         * entities and components, like any other AddRemove transaction.
+         */
+        inline void Restore(const WorldCheckpoint<ECS<Tn...>> &checkpoint) {
+#ifndef TECS_UNCHECKED_MODE
+            if (checkpoint.instance != this) {
+                throw std::runtime_error("Checkpoint was not created from this ECS instance");
+            }
+#endif
+            auto lock = StartTransaction<AddRemove>();
+            if (checkpoint.commitCounts[0] != metadata.commitCount) {
+                lock.base->writeAccessedFlags[0] = true;
+
+                // Storage never shrinks, so any indexes allocated since the checkpoint are cleared instead.
+                // Generations are never rewound, so entities created since the checkpoint can't be aliased by new
+                // entities reusing their index. If an entity's index was reused since the checkpoint, it is restored
+                // with a new generation instead.
+                auto &writeMetadata = metadata.writeComponents;
+                for (size_t index = 0; index < checkpoint.metadata.size(); index++) {
+                    auto generation = writeMetadata[index].generation;
+                    auto &restored = checkpoint.metadata[index];
+                    writeMetadata[index] = restored;
+                    if (!restored[0]) {
+                        writeMetadata[index].generation = std::max(restored.generation, generation);
+                    } else if (restored.generation != generation) {
+                        writeMetadata[index].generation = generation + 1;
+                    }
+                }
+                for (size_t index = checkpoint.metadata.size(); index < writeMetadata.size(); index++) {
+                    writeMetadata[index].reset();
+                }
+                metadata.MarkAllChanged();
+                globalWriteMetadata = checkpoint.globalMetadata;
+            }
+            (RestoreComponents<Tn>(lock, checkpoint), ...);
+        }
+
+        /**
+         * Create a new, independent ECS instance containing all committed entities and components.
+         *
+         * Entities keep their ids in the fork, so Entity references stored in components remain valid. Transactions
+         * on the fork never block this instance, which makes it suitable for speculative work on other threads.
+         * The fork shares the committed storage of each component type instead of copying it, so forking only read
+         * locks this instance for as long as it takes to reference each type's storage. Sharing is per type, not per
+         * entity: the first transaction with write access to a type on the fork copies that type's whole storage,
+         * even if it only writes a single entity. Likewise, the next commit to a shared type on this instance
+         * allocates a new buffer rather than overwriting the shared one, and copies the whole committed storage back
+         * into its write buffer. Deferred writes that haven't been published, observers, and component history are
+         * not shared. Commit ticks and change ticks are shared, so ticks taken from this instance can be passed to
+         * EntitiesChangedSince() on the fork. The fork's stats start with the same valid entity counts, but its lock
+         * contention and commit copy counters start at zero.
+         */
+        inline std::unique_ptr<ECS<Tn...>> Fork() {
+            auto fork = std::make_unique<ECS<Tn...>>();
+            auto lock = StartTransaction<ReadAll>();
+            fork->metadata.ShareReadStorage(metadata);
+            fork->globalReadMetadata = globalReadMetadata;
+            fork->globalWriteMetadata = globalReadMetadata;
+            (fork->template Storage<Tn>().ShareReadStorage(Storage<Tn>()), ...);
+            return fork;
+        }
+
 #ifdef TECS_ENABLE_PERFORMANCE_TRACING
         inline void StartTrace() {
             transactionTrace.StartTrace();
@@ -75,6 +232,21 @@ namespace Tecs {
         }
 #endif
 
+        /**
+         * Returns a snapshot of lock contention, commit sizes, entity counts, and observer backlogs for the metadata
+         * and each Component type.
+         *
+         * No locks are taken, so this can be called from any thread at any time, including from inside a transaction.
+         */
+        inline ECSStats GetStats() const {
+            ECSStats result;
+            result.entities = GetIndexStats("Entities", metadata, std::get<0>(eventLists));
+            result.components = {GetIndexStats(GetComponentName<Tn>(),
+                std::get<ComponentIndex<Tn>>(indexes),
+                std::get<ObserverList<ComponentEvent<Tn>>>(eventLists))...};
+            return result;
+        }
+
         inline TECS_ENTITY_ECS_IDENTIFIER_TYPE GetInstanceId() const {
             return (TECS_ENTITY_ECS_IDENTIFIER_TYPE)ecsId;
         }
@@ -123,16 +295,31 @@ namespace Tecs {
         struct ObserverList {
             std::vector<std::shared_ptr<std::deque<Event>>> observers;
             std::shared_ptr<std::deque<Event>> writeQueue;
+            // Total number of events waiting to be polled by observers, updated at each commit
+            std::atomic_size_t backlog = 0;
 
             void Init() {
                 if (!writeQueue) writeQueue = std::make_shared<std::deque<Event>>();
             }
 
             void Commit() {
-                for (auto &observer : observers) {
-                    observer->insert(observer->end(), writeQueue->begin(), writeQueue->end());
+                if (!observers.empty()) {
+                    // Copy events to all but the last observer, which can take ownership of the queued events.
+                    for (size_t i = 0; i + 1 < observers.size(); i++) {
+                        observers[i]->insert(observers[i]->end(), writeQueue->begin(), writeQueue->end());
+                    }
+                    auto &observer = observers.back();
+                    observer->insert(observer->end(),
+                        std::make_move_iterator(writeQueue->begin()),
+                        std::make_move_iterator(writeQueue->end()));
                 }
                 writeQueue->clear();
+
+                size_t total = 0;
+                for (auto &observer : observers) {
+                    total += observer->size();
+                }
+                backlog.store(total, std::memory_order_relaxed);
             }
         };
 
@@ -149,9 +336,7 @@ namespace Tecs {
 
         using ComponentBitset = std::bitset<1 + sizeof...(Tn)>;
 
-        struct EntityMetadata : public ComponentBitset {
-            TECS_ENTITY_GENERATION_TYPE generation = 0;
-        };
+        using EntityMetadata = Tecs::EntityMetadata<1 + sizeof...(Tn)>;
 
         template<typename... Un>
         inline static constexpr bool BitsetHas(const ComponentBitset &bitset) {
@@ -164,6 +349,68 @@ namespace Tecs {
             return std::get<ComponentIndex<T>>(indexes);
         }
 
+        template<typename U>
+        inline void CheckpointComponents(WorldCheckpoint<ECS<Tn...>> &checkpoint) {
+            constexpr size_t i = 1 + GetComponentIndex<U>();
+            auto &storage = Storage<U>();
+            if (checkpoint.commitCounts[i] == storage.commitCount) return;
+
+            std::get<std::vector<U>>(checkpoint.components) = storage.readComponents;
+            checkpoint.commitCounts[i] = storage.commitCount;
+        }
+
+        template<typename U>
+        inline void RestoreComponents(const Lock<ECS<Tn...>, AddRemove> &lock,
+            const WorldCheckpoint<ECS<Tn...>> &checkpoint) {
+            auto &storage = Storage<U>();
+            // Unpublished deferred writes don't change the commit count, but still need to be discarded.
+            if (checkpoint.commitCounts[1 + GetComponentIndex<U>()] == storage.commitCount && !storage.unpublished) {
+                return;
+            }
+
+            lock.base->template SetAccessFlag<U>(true);
+            auto &components = std::get<std::vector<U>>(checkpoint.components);
+            std::copy(components.begin(), components.end(), storage.writeComponents.begin());
+            storage.MarkAllChanged();
+        }
+
+        /**
+         * Fill in the write storage of each type in writePermissions that is still shared from the instance this was
+         * forked from. Must be called while holding the write locks, before any writes are made.
+         */
+        inline void PrepareWriteStorage(const ComponentBitset &writePermissions) {
+            if (writePermissions[0] && metadata.writeStoragePending) {
+                metadata.PrepareWriteStorage();
+
+                const auto &readMetadata = metadata.readComponents;
+                for (TECS_ENTITY_INDEX_TYPE index = 0; index < readMetadata.size(); index++) {
+                    if (!readMetadata[index][0]) {
+                        freeEntities.emplace_back(index,
+                            readMetadata[index].generation + 1,
+                            GetInstanceId());
+                    }
+                }
+            }
+            ((writePermissions[1 + GetComponentIndex<Tn>()] ? Storage<Tn>().PrepareWriteStorage() : void()), ...);
+        }
+
+        template<typename T, typename Event>
+        inline static ComponentStats GetIndexStats(std::string name,
+            const ComponentIndex<T> &storage,
+            const ObserverList<Event> &observerList) {
+            ComponentStats result;
+            result.name = std::move(name);
+            if constexpr (!std::is_same<T, EntityMetadata>()) result.global = is_global_component<T>();
+            result.validEntityCount = storage.stats.validEntityCount.load(std::memory_order_relaxed);
+            result.commitCount = storage.commitCount.load(std::memory_order_relaxed);
+            result.lastCommitCopies = storage.stats.lastCommitCopies.load(std::memory_order_relaxed);
+            result.readLockWaits = storage.stats.readLockWaits.load(std::memory_order_relaxed);
+            result.writeLockWaits = storage.stats.writeLockWaits.load(std::memory_order_relaxed);
+            result.commitLockWaits = storage.stats.commitLockWaits.load(std::memory_order_relaxed);
+            result.observerBacklog = observerList.backlog.load(std::memory_order_relaxed);
+            return result;
+        }
+
         template<typename Event>
         inline constexpr ObserverList<Event> &Observers() {
             static_assert(contains<Event, EntityEvent, ComponentEvent<Tn>...>(), "Event is not registered with Tecs");
@@ -175,6 +422,8 @@ namespace Tecs {
         ComponentBitset globalWriteMetadata;
         std::tuple<ComponentIndex<Tn>...> indexes;
         std::deque<Entity> freeEntities;
+        // Entities taken from freeEntities by the current AddRemove transaction, returned to it if the transaction is aborted
+        std::vector<Entity> takenFreeEntities;
 
         std::tuple<ObserverList<EntityEvent>, ObserverList<ComponentEvent<Tn>>...> eventLists;
 
@@ -186,12 +435,19 @@ namespace Tecs {
         size_t ecsId;
 #endif
 
+        // Declared last so that any pending async commits complete before the rest of the instance is destroyed
+        AsyncCommitThread asyncCommitThread;
+
         template<typename, typename...>
         friend class Lock;
         template<typename, typename...>
         friend class Transaction;
         template<template<typename...> typename, typename...>
         friend class BaseTransaction;
+        template<template<typename...> typename, typename...>
+        friend class DynamicTransaction;
+        template<typename>
+        friend class WorldCheckpoint;
         friend struct Entity;
     };
 } // namespace Tecs
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Tecs_permissions.hh"
+
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <tuple>
+#include <vector>
+
+namespace Tecs {
+    template<typename ECSType>
+    class WorldCheckpoint;
+
+    /**
+     * A WorldCheckpoint holds a copy of all committed entities and components in an ECS instance, created by
+     * ecs.Checkpoint() and applied with ecs.Restore(checkpoint).
+     *
+     * Each component type is stored as a single bulk copy of its committed storage. The checkpoint also records how
+     * many commits each component type had seen when it was copied, so types that haven't been committed since are
+     * skipped both when restoring, and when an existing checkpoint is updated with ecs.Checkpoint(checkpoint).
+     *
+     * A checkpoint can only be restored into the ECS instance it was created from.
+     */
+    template<typename... Tn>
+    class WorldCheckpoint<ECS<Tn...>> {
+    public:
+        WorldCheckpoint() {}
+
+        /**
+         * Returns true if this checkpoint holds a copy of an ECS instance.
+         */
+        inline bool IsValid() const {
+            return instance != nullptr;
+        }
+
+        /**
+         * Returns the number of entity indexes stored in this checkpoint, including indexes with no entity.
+         */
+        inline size_t Size() const {
+            return metadata.size();
+        }
+
+    private:
+        using EntityMetadata = typename ECS<Tn...>::EntityMetadata;
+
+        const ECS<Tn...> *instance = nullptr;
+        std::vector<EntityMetadata> metadata;
+        std::bitset<1 + sizeof...(Tn)> globalMetadata;
+        std::tuple<std::vector<Tn>...> components;
+        // The commit count of the metadata and each component type at the time it was copied
+        std::array<size_t, 1 + sizeof...(Tn)> commitCounts = {};
+
+        template<typename...>
+        friend class ECS;
+    };
+}; // namespace Tecs
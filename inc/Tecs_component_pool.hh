@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+
+namespace Tecs {
+    /**
+     * Returns a memory pool shared by all values of ComponentType, across every ECS instance.
+     *
+     * Components that own heap memory, such as a std::vector member, can allocate it from this pool with a
+     * ComponentAllocator. Spawning entities and copying values between a component's read and write buffers at commit
+     * then reuse blocks freed by earlier values of the same type, instead of going through the global heap.
+     *
+     * The pool is thread-safe. It is never freed, so components stored in static ECS instances can still be destroyed
+     * safely at exit.
+     */
+    template<typename ComponentType>
+    inline std::pmr::memory_resource &GetComponentPool() {
+        static auto *pool = new std::pmr::synchronized_pool_resource();
+        return *pool;
+    }
+
+    /**
+     * A ComponentAllocator<T, ComponentType> is a stateless allocator for memory owned by a component, allocated from
+     * the component type's pool returned by GetComponentPool<ComponentType>().
+     *
+     * Since every ComponentAllocator for the same component type is equal, containers using it keep allocating from
+     * the pool when they are default constructed, copied, or moved, so component types don't need custom constructors:
+     *
+     * struct Script {
+     *     std::vector<uint32_t, Tecs::ComponentAllocator<uint32_t, Script>> data;
+     * };
+     *
+     * Combined with TECS_RECYCLE_COMPONENT(Script), removed components keep their capacity in place, and any memory
+     * they do free is returned to the pool for the next value to use.
+     */
+    template<typename T, typename ComponentType>
+    class ComponentAllocator {
+    public:
+        using value_type = T;
+
+        ComponentAllocator() noexcept {}
+        template<typename U>
+        ComponentAllocator(const ComponentAllocator<U, ComponentType> &) noexcept {}
+
+        inline T *allocate(size_t n) {
+            if (n > SIZE_MAX / sizeof(T)) throw std::bad_array_new_length();
+            return static_cast<T *>(GetComponentPool<ComponentType>().allocate(n * sizeof(T), alignof(T)));
+        }
+
+        inline void deallocate(T *ptr, size_t n) noexcept {
+            GetComponentPool<ComponentType>().deallocate(ptr, n * sizeof(T), alignof(T));
+        }
+
+        template<typename U>
+        inline bool operator==(const ComponentAllocator<U, ComponentType> &) const noexcept {
+            return true;
+        }
+
+        template<typename U>
+        inline bool operator!=(const ComponentAllocator<U, ComponentType> &) const noexcept {
+            return false;
+        }
+    };
+}; // namespace Tecs
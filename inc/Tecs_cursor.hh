@@ -0,0 +1,102 @@
+#pragma once
+
+#include "Tecs_entity.hh"
+#include "Tecs_entity_view.hh"
+#include "Tecs_permissions.hh"
+
+#include <cstddef>
+#include <type_traits>
+
+namespace Tecs {
+    /**
+     * An EntityCursor iterates over all entities with component T (or all entities if T is void) in bounded chunks,
+     * spread across any number of transactions.
+     *
+     * Each call to Next() returns a view of at most maxCount entities, continuing from where the previous call left
+     * off. The committed entity lists are always sorted by entity index, and an entity keeps the same index for its
+     * whole lifetime, so the cursor only needs to remember the next index to visit. Entities created or destroyed
+     * between transactions can't shift the cursor's position: every entity that exists for the whole iteration is
+     * returned exactly once, entities destroyed before they are reached are skipped, and new entities are only returned
+     * if they are given an index past the cursor. A recycled index is given a new generation, so it is always a
+     * different entity from the one previously visited at that index.
+     *
+     * The cursor reads the entity lists as of the start of the transaction. When used with an AddRemove lock, entities
+     * added or removed within the same transaction won't be reflected until it is committed.
+     */
+    template<typename T = void>
+    class EntityCursor {
+    public:
+        static_assert(std::is_void<T>() || !is_global_component<T>(), "Entities can't have global components");
+
+        EntityCursor() {}
+
+        /**
+         * Returns the next chunk of up to maxCount entities, or an empty view once iteration has completed.
+         * Iteration completes the first time there are no entities left at or past the cursor, so entities added past
+         * the cursor after the previous chunk was returned are still visited.
+         *
+         * The returned view is only valid for the lifetime of the provided lock.
+         */
+        template<typename LockType>
+        inline EntityView Next(const LockType &lock, size_t maxCount) {
+            if constexpr (!std::is_void<T>()) {
+                static_assert(is_read_allowed<T, LockType>(), "Lock does not have read permissions for component");
+            }
+            if (done || maxCount == 0) return EntityView();
+
+            EntityView entities;
+            if constexpr (std::is_void<T>()) {
+                entities = lock.PreviousEntities();
+            } else {
+                entities = lock.template PreviousEntitiesWith<T>();
+            }
+
+            // Binary search for the first entity at or past the cursor position.
+            size_t offset = 0;
+            size_t count = entities.size();
+            while (count > 0) {
+                size_t step = count / 2;
+                if (entities[offset + step].index < nextIndex) {
+                    offset += step + 1;
+                    count -= step + 1;
+                } else {
+                    count = step;
+                }
+            }
+            if (offset >= entities.size()) {
+                done = true;
+                return EntityView();
+            }
+
+            auto chunk = entities.subview(offset, maxCount);
+            nextIndex = (size_t)entities[offset + chunk.size() - 1].index + 1;
+            return chunk;
+        }
+
+        /**
+         * Returns true once a call to Next() has found no entities left to return.
+         */
+        inline bool Done() const {
+            return done;
+        }
+
+        /**
+         * Returns the entity index the next call to Next() will start from.
+         */
+        inline size_t Position() const {
+            return nextIndex;
+        }
+
+        /**
+         * Restarts iteration from the first entity.
+         */
+        inline void Reset() {
+            nextIndex = 0;
+            done = false;
+        }
+
+    private:
+        size_t nextIndex = 0;
+        bool done = false;
+    };
+}; // namespace Tecs
@@ -0,0 +1,430 @@
+#pragma once
+
+#include "Tecs_entity.hh"
+#include "Tecs_permissions.hh"
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+
+#ifndef TECS_DYNAMIC_COMPONENT_SIZE
+    #define TECS_DYNAMIC_COMPONENT_SIZE 64
+#endif
+
+#ifndef TECS_DYNAMIC_COMPONENT_ALIGNMENT
+    #define TECS_DYNAMIC_COMPONENT_ALIGNMENT alignof(std::max_align_t)
+#endif
+
+namespace Tecs {
+    /**
+     * Describes a component type registered at runtime, such as a component defined by a script or mod.
+     *
+     * Trivial types are copied with memcpy and never destroyed; other types must provide the copy, move, and destroy
+     * functions. Values are always stored inline in a DynamicComponent slot, so a type can only be registered to a
+     * slot that fits its size and alignment.
+     */
+    struct DynamicComponentType {
+        std::string name;
+        size_t size = 0;
+        size_t alignment = 1;
+        bool trivial = false;
+        // True if the move function never throws. Non-trivial types are only accepted if this is set, so that
+        // DynamicComponent slots can be moved without throwing when storage is resized.
+        bool nothrowMove = false;
+
+        // Constructs a default value in uninitialized storage. If null, the value is zero-filled instead.
+        void (*construct)(void *dst) = nullptr;
+        // Copy or move construct a value into uninitialized storage. Unused for trivial types.
+        void (*copy)(void *dst, const void *src) = nullptr;
+        void (*move)(void *dst, void *src) = nullptr;
+        // Destroys a value, leaving the storage uninitialized. Unused for trivial types.
+        void (*destroy)(void *dst) = nullptr;
+
+        // Identifies the native type created by Of<T>(), so values can be accessed with DynamicComponent::Get<T>()
+        const void *nativeType = nullptr;
+
+        /**
+         * Returns a type description for a native C++ type T.
+         */
+        template<typename T>
+        static DynamicComponentType Of(const std::string &name) {
+            DynamicComponentType type;
+            type.name = name;
+            type.size = sizeof(T);
+            type.alignment = alignof(T);
+            type.trivial = std::is_trivially_copyable<T>() && std::is_trivially_destructible<T>();
+            type.nothrowMove = std::is_nothrow_move_constructible<T>();
+            type.construct = [](void *dst) {
+                new (dst) T();
+            };
+            type.copy = [](void *dst, const void *src) {
+                new (dst) T(*static_cast<const T *>(src));
+            };
+            type.move = [](void *dst, void *src) {
+                new (dst) T(std::move(*static_cast<T *>(src)));
+            };
+            type.destroy = [](void *dst) {
+                static_cast<T *>(dst)->~T();
+            };
+            type.nativeType = NativeTypeId<T>();
+            return type;
+        }
+
+        /**
+         * Returns a type description for a plain block of bytes, zero-filled by default.
+         * If alignment is 0, the largest power of two dividing size is used, up to alignof(std::max_align_t).
+         */
+        static DynamicComponentType Bytes(const std::string &name, size_t size, size_t alignment = 0) {
+            DynamicComponentType type;
+            type.name = name;
+            type.size = size;
+            if (alignment == 0) {
+                alignment = 1;
+                while (alignment < alignof(std::max_align_t) && size % (alignment * 2) == 0) {
+                    alignment *= 2;
+                }
+            }
+            type.alignment = alignment;
+            type.trivial = true;
+            type.nothrowMove = true;
+            return type;
+        }
+
+        template<typename T>
+        static const void *NativeTypeId() {
+            static const char id = 0;
+            return &id;
+        }
+    };
+
+    /**
+     * A DynamicComponent<Slot, Size, Alignment> is a placeholder component type that can hold a value of any
+     * DynamicComponentType.
+     *
+     * Listing DynamicComponent slots in an ECS's component types reserves storage for components registered at runtime
+     * with a DynamicComponentRegistry. Each slot is stored contiguously like any other component type, and takes part
+     * in the same locking and commit process, so runtime components can be iterated with EntitiesWith<>().
+     *
+     * Each element stores values of up to Size bytes inline, plus a pointer to the value's type. Slots should be
+     * sized to match the types expected to be registered in them, since every entity pays for the full slot size.
+     * Values are never allocated separately: larger or over-aligned types, and non-trivial types that may throw when
+     * moved, can't be stored in the slot.
+     *
+     * // Example:
+     * using ECSType = Tecs::ECS<A, B, Tecs::DynamicComponent<0>, Tecs::DynamicComponent<1, sizeof(float)>>;
+     */
+    template<size_t Slot, size_t Size = TECS_DYNAMIC_COMPONENT_SIZE,
+        size_t Alignment = TECS_DYNAMIC_COMPONENT_ALIGNMENT>
+    class DynamicComponent {
+        static_assert(Size > 0, "DynamicComponent slots must have a non-zero size");
+
+    public:
+        DynamicComponent() {}
+        DynamicComponent(const DynamicComponentType &type) {
+            Emplace(type);
+        }
+
+        DynamicComponent(const DynamicComponent &other) {
+            CopyFrom(other);
+        }
+
+        DynamicComponent(DynamicComponent &&other) noexcept {
+            MoveFrom(std::move(other));
+        }
+
+        ~DynamicComponent() {
+            Reset();
+        }
+
+        DynamicComponent &operator=(const DynamicComponent &other) {
+            if (this == &other) return *this;
+            if (type && type == other.type && type->trivial) {
+                // Fast path used when copying between the read and write buffers during commit
+                std::memcpy(data, other.data, type->size);
+            } else {
+                Reset();
+                CopyFrom(other);
+            }
+            return *this;
+        }
+
+        DynamicComponent &operator=(DynamicComponent &&other) noexcept {
+            if (this == &other) return *this;
+            Reset();
+            MoveFrom(std::move(other));
+            return *this;
+        }
+
+        /**
+         * Returns true if values of the provided type can be stored in this slot.
+         */
+        static inline constexpr bool StoresInline(const DynamicComponentType &type) {
+            return type.size <= Size && type.alignment <= Alignment && (type.trivial || type.nothrowMove);
+        }
+
+        /**
+         * Replace the current value with a default constructed value of the provided type.
+         * Throws if the type can't be stored in this slot.
+         */
+        inline void Emplace(const DynamicComponentType &newType) {
+            if (!StoresInline(newType)) {
+                throw std::runtime_error("Dynamic component type does not fit in slot: " + newType.name);
+            }
+            Reset();
+            if (newType.construct) {
+                newType.construct(data);
+            } else {
+                std::memset(data, 0, newType.size);
+            }
+            type = &newType;
+        }
+
+        inline void Reset() noexcept {
+            if (!type) return;
+            if (!type->trivial) type->destroy(data);
+            type = nullptr;
+        }
+
+        inline bool HasValue() const {
+            return type != nullptr;
+        }
+
+        inline const DynamicComponentType *Type() const {
+            return type;
+        }
+
+        inline void *Data() {
+            return type ? data : nullptr;
+        }
+
+        inline const void *Data() const {
+            return type ? data : nullptr;
+        }
+
+        template<typename T>
+        inline T &Get() {
+            CheckType<T>();
+            return *std::launder(reinterpret_cast<T *>(data));
+        }
+
+        template<typename T>
+        inline const T &Get() const {
+            CheckType<T>();
+            return *std::launder(reinterpret_cast<const T *>(data));
+        }
+
+    private:
+        template<typename T>
+        inline void CheckType() const {
+#ifndef TECS_UNCHECKED_MODE
+            if (!type || type->nativeType != DynamicComponentType::NativeTypeId<T>()) {
+                throw std::runtime_error("Dynamic component does not hold a value of type: " +
+                                         std::string(typeid(T).name()));
+            }
+#endif
+        }
+
+        inline void CopyFrom(const DynamicComponent &other) {
+            if (!other.type) return;
+            if (other.type->trivial) {
+                std::memcpy(data, other.data, other.type->size);
+            } else {
+                other.type->copy(data, other.data);
+            }
+            type = other.type;
+        }
+
+        inline void MoveFrom(DynamicComponent &&other) noexcept {
+            if (!other.type) return;
+            if (other.type->trivial) {
+                std::memcpy(data, other.data, other.type->size);
+            } else {
+                other.type->move(data, other.data);
+            }
+            type = other.type;
+        }
+
+        alignas(Alignment) unsigned char data[Size];
+        const DynamicComponentType *type = nullptr;
+    };
+
+    template<typename T>
+    struct is_dynamic_component : std::false_type {};
+    template<size_t Slot, size_t Size, size_t Alignment>
+    struct is_dynamic_component<DynamicComponent<Slot, Size, Alignment>> : std::true_type {};
+
+    /**
+     * A DynamicComponentRegistry assigns runtime component types to the DynamicComponent slots of an ECS.
+     *
+     * Registered components are identified by their component index, which can be used to build permission bitsets
+     * for ecs.StartTransaction(readPermissions, writePermissions). Values are accessed through a DynamicLock, with
+     * permissions checked at runtime. The registry owns the registered types, and must outlive any components using
+     * them.
+     */
+    template<typename ECSType>
+    class DynamicComponentRegistry {};
+
+    template<typename... Tn>
+    class DynamicComponentRegistry<ECS<Tn...>> {
+    public:
+        DynamicComponentRegistry() {}
+        // Delete copy constructor, since components reference the registered types by address
+        DynamicComponentRegistry(const DynamicComponentRegistry &) = delete;
+
+        /**
+         * Assign a type to the first free DynamicComponent slot that can store its values inline, and return its
+         * component index. Throws if no free slot is large enough, rather than allocating values separately.
+         */
+        inline size_t Register(const DynamicComponentType &type) {
+            if (type.alignment == 0 || (type.alignment & (type.alignment - 1)) != 0) {
+                throw std::runtime_error("Dynamic component type alignment is not a power of two: " + type.name);
+            } else if (!type.trivial && (!type.copy || !type.move || !type.destroy)) {
+                throw std::runtime_error("Non-trivial dynamic component type is missing functions: " + type.name);
+            }
+            for (size_t i = 0; i < slots.size(); i++) {
+                if (slots[i] && slots[i]->name == type.name) {
+                    throw std::runtime_error("Dynamic component type is already registered: " + type.name);
+                }
+            }
+            bool hasFreeSlot = false;
+            for (size_t i = 0; i < slots.size(); i++) {
+                if (!isDynamic[i] || slots[i]) continue;
+                hasFreeSlot = true;
+                if (StoresInline(i, type)) {
+                    slots[i] = &types.emplace_back(type);
+                    return i;
+                }
+            }
+            if (hasFreeSlot) {
+                throw std::runtime_error("No free DynamicComponent slot can store type inline: " + type.name);
+            }
+            throw std::runtime_error("No free DynamicComponent slots to register type: " + type.name);
+        }
+
+        /**
+         * Returns the component index of a registered type by name.
+         */
+        inline size_t Find(const std::string &name) const {
+            for (size_t i = 0; i < slots.size(); i++) {
+                if (slots[i] && slots[i]->name == name) return i;
+            }
+            throw std::runtime_error("Dynamic component type is not registered: " + name);
+        }
+
+        inline const DynamicComponentType &GetType(size_t componentIndex) const {
+            if (componentIndex >= slots.size() || !slots[componentIndex]) {
+                throw std::runtime_error("Component index is not a registered dynamic component: " +
+                                         std::to_string(componentIndex));
+            }
+            return *slots[componentIndex];
+        }
+
+        template<typename LockType>
+        inline bool Has(const LockType &lock, const Entity &entity, size_t componentIndex) const {
+            bool result = false;
+            Dispatch(componentIndex, [&](auto *slot) {
+                using SlotType = std::remove_pointer_t<decltype(slot)>;
+                auto metadataLock = lock.template TryLock<>();
+                result = metadataLock && entity.Has<SlotType>(*metadataLock);
+            });
+            return result;
+        }
+
+        /**
+         * Returns a pointer to an entity's value for the dynamic component. The lock must allow reading the slot.
+         */
+        template<typename LockType>
+        inline const void *Get(const LockType &lock, const Entity &entity, size_t componentIndex) const {
+            const void *result = nullptr;
+            Dispatch(componentIndex, [&](auto *slot) {
+                using SlotType = std::remove_pointer_t<decltype(slot)>;
+                auto readLock = lock.template TryLock<Read<SlotType>>();
+                if (!readLock) ThrowPermissionError("read", componentIndex);
+                result = entity.Get<const SlotType>(*readLock).Data();
+            });
+            return result;
+        }
+
+        /**
+         * Returns a mutable pointer to an entity's value for the dynamic component, adding a default value if it
+         * doesn't exist yet. The lock must allow writing the slot, and have AddRemove permissions to add new values.
+         */
+        template<typename LockType>
+        inline void *Set(const LockType &lock, const Entity &entity, size_t componentIndex) const {
+            void *result = nullptr;
+            Dispatch(componentIndex, [&](auto *slot) {
+                using SlotType = std::remove_pointer_t<decltype(slot)>;
+                SlotType *value = nullptr;
+                if (auto addRemoveLock = lock.template TryLock<AddRemove>()) {
+                    value = &entity.Get<SlotType>(*addRemoveLock);
+                } else if (auto writeLock = lock.template TryLock<Write<SlotType>>()) {
+                    value = &entity.Get<SlotType>(*writeLock);
+                } else {
+                    ThrowPermissionError("write", componentIndex);
+                }
+                if (value->Type() != slots[componentIndex]) value->Emplace(*slots[componentIndex]);
+                result = value->Data();
+            });
+            return result;
+        }
+
+        /**
+         * Removes the dynamic component from an entity. The lock must have AddRemove permissions.
+         */
+        template<typename LockType>
+        inline void Unset(const LockType &lock, const Entity &entity, size_t componentIndex) const {
+            Dispatch(componentIndex, [&](auto *slot) {
+                using SlotType = std::remove_pointer_t<decltype(slot)>;
+                auto addRemoveLock = lock.template TryLock<AddRemove>();
+                if (!addRemoveLock) ThrowPermissionError("add/remove", componentIndex);
+                entity.Unset<SlotType>(*addRemoveLock);
+            });
+        }
+
+    private:
+        // Returns true if the DynamicComponent slot at componentIndex stores values of type inline
+        static inline bool StoresInline(size_t componentIndex, const DynamicComponentType &type) {
+            bool result = false;
+            (
+                [&] {
+                    if constexpr (is_dynamic_component<Tn>()) {
+                        if (componentIndex == ECS<Tn...>::template GetComponentIndex<Tn>()) {
+                            result = Tn::StoresInline(type);
+                        }
+                    }
+                }(),
+                ...);
+            return result;
+        }
+
+        // Calls fn with a null pointer of the DynamicComponent slot type at componentIndex
+        template<typename Fn>
+        inline void Dispatch(size_t componentIndex, Fn &&fn) const {
+            GetType(componentIndex);
+            (
+                [&] {
+                    if constexpr (is_dynamic_component<Tn>()) {
+                        if (componentIndex == ECS<Tn...>::template GetComponentIndex<Tn>()) fn((Tn *)nullptr);
+                    }
+                }(),
+                ...);
+        }
+
+        [[noreturn]] inline void ThrowPermissionError(const char *access, size_t componentIndex) const {
+            throw std::runtime_error(std::string("Lock does not have ") + access +
+                                     " permissions for dynamic component: " + slots[componentIndex]->name);
+        }
+
+        static constexpr std::array<bool, sizeof...(Tn)> isDynamic = {is_dynamic_component<Tn>()...};
+
+        std::array<const DynamicComponentType *, sizeof...(Tn)> slots = {};
+        std::deque<DynamicComponentType> types;
+    };
+}; // namespace Tecs
@@ -149,8 +149,9 @@ namespace Tecs {
                     lock.base->writeAccessedFlags[0] = true;
 
                     // Reset value before allowing reading.
-                    storage.writeComponents[index] = {};
+                    component_recycler<CompType>::Recycle(storage.writeComponents[index]);
                     metadata[1 + lock.instance.template GetComponentIndex<CompType>()] = true;
+                    lock.instance.metadata.MarkChanged(index);
                     auto &validEntities = storage.writeValidEntities;
                     storage.validEntityIndexes[index] = validEntities.size();
                     validEntities.emplace_back(*this);
@@ -162,6 +163,7 @@ namespace Tecs {
 #endif
             }
 
+            if constexpr (!std::is_const<ReturnType>()) storage.MarkChanged(index);
             if (lock.instance.template BitsetHas<CompType>(lock.permissions)) {
                 return storage.writeComponents[index];
             } else {
@@ -223,6 +225,7 @@ namespace Tecs {
                     lock.base->writeAccessedFlags[0] = true;
 
                     metadata[1 + lock.instance.template GetComponentIndex<T>()] = true;
+                    lock.instance.metadata.MarkChanged(index);
                     auto &validEntities = lock.instance.template Storage<T>().writeValidEntities;
                     lock.instance.template Storage<T>().validEntityIndexes[index] = validEntities.size();
                     validEntities.emplace_back(*this);
@@ -232,11 +235,12 @@ namespace Tecs {
                 throw std::runtime_error("Entity does not have a component of type: " + std::string(typeid(T).name()));
 #endif
             }
+            lock.instance.template Storage<T>().MarkChanged(index);
             return lock.instance.template Storage<T>().writeComponents[index] = value;
         }
 
         template<typename T, typename LockType, typename... Args>
-        inline T &Set(const LockType &lock, Args... args) const {
+        inline T &Set(const LockType &lock, Args &&...args) const {
             static_assert(is_write_allowed<T, LockType>(), "Component is not locked for writing.");
             static_assert(!is_global_component<T>(), "Global components must be accessed through lock.Set()");
             lock.base->template SetAccessFlag<T>(true);
@@ -264,6 +268,7 @@ namespace Tecs {
                     lock.base->writeAccessedFlags[0] = true;
 
                     metadata[1 + lock.instance.template GetComponentIndex<T>()] = true;
+                    lock.instance.metadata.MarkChanged(index);
                     auto &validEntities = lock.instance.template Storage<T>().writeValidEntities;
                     lock.instance.template Storage<T>().validEntityIndexes[index] = validEntities.size();
                     validEntities.emplace_back(*this);
@@ -273,7 +278,8 @@ namespace Tecs {
                 throw std::runtime_error("Entity does not have a component of type: " + std::string(typeid(T).name()));
 #endif
             }
-            return lock.instance.template Storage<T>().writeComponents[index] = T(std::forward<Args>(args)...);
+            lock.instance.template Storage<T>().MarkChanged(index);
+            return lock.instance.template Storage<T>().WriteEmplace(index, std::forward<Args>(args)...);
         }
 
         template<typename... Tn, typename LockType>
@@ -317,8 +323,8 @@ namespace Tecs {
             // Invalidate the entity and all of its Components
             lock.RemoveAllComponents(copy);
             lock.instance.metadata.writeComponents[copy][0] = false;
-            size_t validIndex = lock.instance.metadata.validEntityIndexes[copy];
-            lock.instance.metadata.writeValidEntities[validIndex] = Entity();
+            lock.instance.metadata.MarkChanged(copy);
+            lock.instance.metadata.RemoveValidEntity(copy);
         }
 
         template<typename LockType>
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Tecs_entity.hh"
+#include "nonstd/span.hpp"
 
 #include <iterator>
 #include <limits>
@@ -150,6 +151,25 @@ namespace Tecs {
             return (*storage)[index];
         }
 
+        /**
+         * Returns a pointer to the first entity in the view, or nullptr if the view has no storage.
+         */
+        inline pointer data() const noexcept {
+            return storage ? storage->data() + start_index : nullptr;
+        }
+
+        /**
+         * Returns a pointer-based contiguous span over the entities in the view.
+         *
+         * The view's bounds are checked when it is constructed, so the span is iterated with no per-element checks,
+         * and can be passed to standard algorithms, including parallel ones, like any contiguous range. Unlike the
+         * view itself, the span is invalidated if the underlying entity list is reallocated, such as when entities are
+         * added during an AddRemove transaction.
+         */
+        inline nonstd::span<const Entity> span() const noexcept {
+            return nonstd::span<const Entity>(data(), size());
+        }
+
         inline size_type size() const noexcept {
             return end_index - start_index;
         }
@@ -162,7 +182,9 @@ namespace Tecs {
 #ifndef TECS_UNCHECKED_MODE
             if (storage == nullptr) throw std::runtime_error("EntityView::subview storage is null");
 #endif
-            return EntityView(*storage, start_index + offset, std::min(end_index, start_index + offset + count));
+            size_t start = start_index + offset;
+            size_t remaining = end_index - std::min(start, end_index);
+            return EntityView(*storage, start, count < remaining ? start + count : end_index);
         }
 
     private:
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <utility>
+
+// Number of independently locked shards each Flyweight type's interned values are split between by hash.
+#ifndef TECS_FLYWEIGHT_POOL_SHARDS
+    #define TECS_FLYWEIGHT_POOL_SHARDS 16
+#endif
+
+namespace Tecs {
+    /**
+     * A Flyweight<T> component references a shared, immutable value of T instead of storing its own copy.
+     *
+     * Values are interned when a Flyweight is constructed, so entities set to equal values all reference the same
+     * instance. Component storage, and the copies made between the read and write buffers at commit, only hold the
+     * reference. This is intended for large components that are mostly shared between entities, such as mesh or
+     * configuration descriptors. T must be equality comparable and hashable with Hash.
+     *
+     * To change an entity's value, set a new Flyweight rather than modifying the referenced value:
+     *
+     * entity.Set<Tecs::Flyweight<Mesh>>(lock, newMesh);
+     *
+     * Interned values are freed once no Flyweight references them.
+     *
+     * Interned values are split between shards by hash, each with its own reader/writer lock. Interning a value that
+     * already exists only takes a shared lock on its shard, so concurrent lookups don't contend with each other. New
+     * values, and releasing the last reference to a value, lock only the value's shard exclusively.
+     */
+    template<typename T, typename Hash = std::hash<T>>
+    class Flyweight {
+    public:
+        Flyweight() {}
+        Flyweight(const T &value) : value(Intern(T(value))) {}
+        Flyweight(T &&value) : value(Intern(std::move(value))) {}
+
+        inline const T &Get() const {
+            return *value;
+        }
+
+        inline const T &operator*() const {
+            return *value;
+        }
+
+        inline const T *operator->() const {
+            return value.get();
+        }
+
+        inline explicit operator bool() const {
+            return value != nullptr;
+        }
+
+        // Interned values are unique, so comparing references is equivalent to comparing values.
+        inline bool operator==(const Flyweight &other) const {
+            return value == other.value;
+        }
+
+        inline bool operator!=(const Flyweight &other) const {
+            return value != other.value;
+        }
+
+        /**
+         * Returns the number of distinct values currently interned for this Flyweight type.
+         */
+        static size_t InternedCount() {
+            size_t count = 0;
+            for (auto &shard : GetPool()) {
+                std::shared_lock<std::shared_mutex> lock(shard.mutex);
+                count += shard.values.size();
+            }
+            return count;
+        }
+
+    private:
+        struct Shard {
+            std::shared_mutex mutex;
+            std::unordered_multimap<size_t, std::weak_ptr<const T>> values;
+        };
+
+        using Pool = std::array<Shard, TECS_FLYWEIGHT_POOL_SHARDS>;
+
+        // The pool is never freed, so it outlives any interned values still held by static ECS instances.
+        static Pool &GetPool() {
+            static Pool *pool = new Pool();
+            return *pool;
+        }
+
+        // Returns the interned value equal to value, or nullptr if there is none. The shard must be locked.
+        static std::shared_ptr<const T> Find(const Shard &shard, size_t hash, const T &value) {
+            auto range = shard.values.equal_range(hash);
+            for (auto it = range.first; it != range.second; it++) {
+                auto existing = it->second.lock();
+                if (existing && *existing == value) return existing;
+            }
+            return nullptr;
+        }
+
+        static std::shared_ptr<const T> Intern(T &&newValue) {
+            size_t hash = Hash()(newValue);
+            Shard &shard = GetPool()[hash % TECS_FLYWEIGHT_POOL_SHARDS];
+            {
+                std::shared_lock<std::shared_mutex> lock(shard.mutex);
+                auto existing = Find(shard, hash, newValue);
+                if (existing) return existing;
+            }
+
+            std::lock_guard<std::shared_mutex> lock(shard.mutex);
+            // Another thread may have interned the value between releasing the shared lock and locking exclusively.
+            auto existing = Find(shard, hash, newValue);
+            if (existing) return existing;
+
+            // Remove the pool entry once the last reference is released.
+            std::shared_ptr<const T> interned(new T(std::move(newValue)), [&shard, hash](const T *ptr) {
+                {
+                    std::lock_guard<std::shared_mutex> lock(shard.mutex);
+                    auto range = shard.values.equal_range(hash);
+                    for (auto it = range.first; it != range.second; it++) {
+                        if (it->second.expired()) {
+                            shard.values.erase(it);
+                            break;
+                        }
+                    }
+                }
+                delete ptr;
+            });
+            shard.values.emplace(hash, interned);
+            return interned;
+        }
+
+        std::shared_ptr<const T> value;
+    };
+}; // namespace Tecs
@@ -0,0 +1,224 @@
+#pragma once
+
+#include "Tecs_stats.hh"
+
+#ifdef _WIN32
+    #error "Tecs_inspector.hh requires POSIX Unix domain sockets"
+#endif
+
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <poll.h>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+
+// Time in milliseconds the Inspector waits for a client to send its requested format before replying with JSON.
+#ifndef TECS_INSPECTOR_REQUEST_TIMEOUT_MS
+    #define TECS_INSPECTOR_REQUEST_TIMEOUT_MS 100
+#endif
+
+namespace Tecs {
+    /**
+     * An Inspector serves live stats snapshots of an ECS instance over a local Unix domain socket, so that lock
+     * contention, commit sizes, entity counts, and observer backlogs can be watched while a program is running.
+     *
+     * Snapshots come from ecs.GetStats(), which only reads atomic counters. The Inspector never takes any locks on
+     * the ECS, so a stalled or slow client can't affect running transactions.
+     *
+     * Clients connect to the socket and may send a single line with the format to reply with, either "json" or
+     * "text". The snapshot is written in that format, defaulting to JSON, and the connection is closed. Clients are
+     * served one at a time on a background thread owned by the Inspector. Inspector::Query() implements the client
+     * side, and is used by the Tecs-inspect command line tool.
+     *
+     * The socket file is created when the Inspector is constructed, and removed when it is destroyed.
+     */
+    class Inspector {
+    public:
+        template<typename ECSType, typename = decltype(std::declval<const ECSType &>().GetStats())>
+        Inspector(const ECSType &ecs, const std::string &socketPath)
+            : getStats([instance = &ecs] {
+                  return instance->GetStats();
+              }),
+              socketPath(socketPath) {
+            Start();
+        }
+
+        Inspector(std::function<ECSStats()> getStats, const std::string &socketPath)
+            : getStats(std::move(getStats)), socketPath(socketPath) {
+            Start();
+        }
+
+        // The background thread references this instance, so it can't be copied or moved.
+        Inspector(const Inspector &) = delete;
+        Inspector &operator=(const Inspector &) = delete;
+
+        ~Inspector() {
+            char stop = 0;
+            while (write(stopPipe[1], &stop, 1) < 0 && errno == EINTR) {}
+            thread.join();
+            close(stopPipe[0]);
+            close(stopPipe[1]);
+            close(listenFd);
+            unlink(socketPath.c_str());
+        }
+
+        inline const std::string &SocketPath() const {
+            return socketPath;
+        }
+
+        /**
+         * Connect to an Inspector listening on socketPath and return its reply in the requested format.
+         */
+        static std::string Query(const std::string &socketPath, const std::string &format = "json") {
+            sockaddr_un address;
+            int fd = OpenSocket(socketPath, address);
+            if (connect(fd, (const sockaddr *)&address, sizeof(address)) != 0) {
+                int error = errno;
+                close(fd);
+                throw std::runtime_error(
+                    std::string("Inspector failed to connect (") + std::strerror(error) + "): " + socketPath);
+            }
+            std::string request = format + "\n";
+            if (!SendAll(fd, request.data(), request.size())) {
+                int error = errno;
+                close(fd);
+                throw std::runtime_error(
+                    std::string("Inspector failed to send request (") + std::strerror(error) + "): " + socketPath);
+            }
+
+            std::string reply;
+            char buffer[4096];
+            while (true) {
+                ssize_t count = recv(fd, buffer, sizeof(buffer), 0);
+                if (count > 0) {
+                    reply.append(buffer, count);
+                } else if (count == 0) {
+                    break;
+                } else if (errno != EINTR) {
+                    int error = errno;
+                    close(fd);
+                    throw std::runtime_error(
+                        std::string("Inspector failed to read reply (") + std::strerror(error) + "): " + socketPath);
+                }
+            }
+            close(fd);
+            return reply;
+        }
+
+    private:
+        void Start() {
+            listenFd = OpenSocket(socketPath, address);
+            if (bind(listenFd, (const sockaddr *)&address, sizeof(address)) != 0) {
+                // Replace a socket file left behind by a previous process, but never any other kind of file.
+                struct stat info;
+                if (errno != EADDRINUSE || lstat(socketPath.c_str(), &info) != 0 || !S_ISSOCK(info.st_mode) ||
+                    unlink(socketPath.c_str()) != 0 ||
+                    bind(listenFd, (const sockaddr *)&address, sizeof(address)) != 0) {
+                    Fail("failed to bind", false);
+                }
+            }
+            if (listen(listenFd, 8) != 0) Fail("failed to listen", true);
+            if (pipe(stopPipe) != 0) Fail("failed to create stop pipe", true);
+            thread = std::thread([this] {
+                Run();
+            });
+        }
+
+        static int OpenSocket(const std::string &path, sockaddr_un &address) {
+            address = {};
+            address.sun_family = AF_UNIX;
+            if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+                throw std::runtime_error("Inspector socket path is empty or too long: " + path);
+            }
+            std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+            int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (fd < 0) {
+                throw std::runtime_error(
+                    std::string("Inspector failed to create socket (") + std::strerror(errno) + "): " + path);
+            }
+#ifdef SO_NOSIGPIPE
+            int enable = 1;
+            setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &enable, sizeof(enable));
+#endif
+            return fd;
+        }
+
+        // Close the listening socket and throw. Only used by the constructor, since the destructor won't run.
+        [[noreturn]] void Fail(const std::string &message, bool bound) {
+            int error = errno;
+            close(listenFd);
+            if (bound) unlink(socketPath.c_str());
+            throw std::runtime_error("Inspector " + message + " (" + std::strerror(error) + "): " + socketPath);
+        }
+
+        static bool SendAll(int fd, const char *data, size_t size) {
+#ifdef MSG_NOSIGNAL
+            const int flags = MSG_NOSIGNAL;
+#else
+            const int flags = 0;
+#endif
+            while (size > 0) {
+                ssize_t count = send(fd, data, size, flags);
+                if (count < 0) {
+                    if (errno == EINTR) continue;
+                    return false;
+                }
+                data += count;
+                size -= count;
+            }
+            return true;
+        }
+
+        void Run() {
+            while (true) {
+                pollfd fds[2] = {{listenFd, POLLIN, 0}, {stopPipe[0], POLLIN, 0}};
+                if (poll(fds, 2, -1) < 0) {
+                    if (errno == EINTR) continue;
+                    return;
+                }
+                if (fds[1].revents) return;
+                if (!(fds[0].revents & POLLIN)) continue;
+
+                int clientFd = accept(listenFd, nullptr, nullptr);
+                if (clientFd < 0) continue;
+                Serve(clientFd);
+                close(clientFd);
+            }
+        }
+
+        void Serve(int clientFd) {
+            std::string request;
+            pollfd fds[2] = {{clientFd, POLLIN, 0}, {stopPipe[0], POLLIN, 0}};
+            while (request.find('\n') == std::string::npos && request.size() < 64) {
+                int ready = poll(fds, 2, TECS_INSPECTOR_REQUEST_TIMEOUT_MS);
+                if (ready < 0 && errno == EINTR) continue;
+                if (ready <= 0 || fds[1].revents) break;
+
+                char buffer[64];
+                ssize_t count = recv(clientFd, buffer, sizeof(buffer), 0);
+                if (count <= 0) break;
+                request.append(buffer, count);
+            }
+            request = request.substr(0, request.find_first_of("\r\n"));
+
+            ECSStats stats = getStats();
+            std::string reply = request == "text" ? stats.ToString() : stats.ToJson() + "\n";
+            SendAll(clientFd, reply.data(), reply.size());
+        }
+
+        std::function<ECSStats()> getStats;
+        std::string socketPath;
+        sockaddr_un address;
+        int listenFd = -1;
+        int stopPipe[2] = {-1, -1};
+        std::thread thread;
+    };
+}; // namespace Tecs
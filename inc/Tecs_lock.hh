@@ -4,16 +4,22 @@
 #include "Tecs_entity_view.hh"
 #include "Tecs_observer.hh"
 #include "Tecs_permissions.hh"
+#include "Tecs_storage.hh"
 #include "Tecs_transaction.hh"
 
+#include <algorithm>
 #include <bitset>
 #include <cstddef>
+#include <future>
 #include <limits>
 #include <memory>
+#include <memory_resource>
 #include <optional>
 #include <stdexcept>
 #include <string>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 #ifndef TECS_ENTITY_ALLOCATION_BATCH_SIZE
     #define TECS_ENTITY_ALLOCATION_BATCH_SIZE 1000
@@ -33,6 +39,7 @@ namespace Tecs {
      * Tecs::ReadAll
      * Tecs::Write<Components...>
      * Tecs::WriteAll
+     * Tecs::WriteDeferred<Components...>
      * Tecs::AddRemove
      *
      * // Examples:
@@ -107,7 +114,7 @@ namespace Tecs {
         inline const EntityView PreviousEntitiesWith() const {
             static_assert(!is_global_component<T>(), "Entities can't have global components");
 
-            return instance.template Storage<T>().readValidEntities;
+            return *instance.template Storage<T>().readValidEntities;
         }
 
         template<typename T>
@@ -117,19 +124,19 @@ namespace Tecs {
             if (permissions[0]) {
                 return instance.template Storage<T>().writeValidEntities;
             } else {
-                return instance.template Storage<T>().readValidEntities;
+                return *instance.template Storage<T>().readValidEntities;
             }
         }
 
         inline const EntityView PreviousEntities() const {
-            return instance.metadata.readValidEntities;
+            return *instance.metadata.readValidEntities;
         }
 
         inline const EntityView Entities() const {
             if (permissions[0]) {
                 return instance.metadata.writeValidEntities;
             } else {
-                return instance.metadata.readValidEntities;
+                return *instance.metadata.readValidEntities;
             }
         }
 
@@ -164,10 +171,12 @@ namespace Tecs {
             } else {
                 entity = instance.freeEntities.front();
                 instance.freeEntities.pop_front();
+                instance.takenFreeEntities.emplace_back(entity);
             }
 
             instance.metadata.writeComponents[entity.index][0] = true;
             instance.metadata.writeComponents[entity.index].generation = entity.generation;
+            instance.metadata.MarkChanged(entity.index);
             auto &validEntities = instance.metadata.writeValidEntities;
             instance.metadata.validEntityIndexes[entity.index] = validEntities.size();
             validEntities.emplace_back(entity);
@@ -175,6 +184,102 @@ namespace Tecs {
             return entity;
         }
 
+        /**
+         * Moves all entities and their components from a staging ECS instance into this instance.
+         * Entities can be constructed in a separate staging instance without holding any locks on this instance,
+         * and then be merged using a short AddRemove transaction. The spliced entities are appended to the end of
+         * this instance's storage, and ADDED events are emitted for them when this transaction is committed.
+         *
+         * The staging entities are destroyed, so the staging instance can be reused once its transaction is committed.
+         * Global components are not spliced.
+         *
+         * Returns a table indexed by staging entity index, containing the new Entity for each spliced entity.
+         * Any Entity references stored inside components are not modified, and should be remapped using this table.
+         *
+         * Note: This function invalidates all references to components if a storage resize occurs.
+         */
+        template<typename... StagingPermissions>
+        inline std::vector<Entity> Splice(const Lock<ECS, StagingPermissions...> &staging) const {
+            static_assert(is_add_remove_allowed<LockType>(), "Lock does not have AddRemove permission.");
+            static_assert(is_add_remove_allowed<Lock<ECS, StagingPermissions...>>(),
+                "Staging lock does not have AddRemove permission.");
+            if (&staging.instance == &instance) {
+                throw std::runtime_error("An ECS instance can't be spliced into itself");
+            }
+
+            auto &stagingEntities = staging.instance.metadata.writeValidEntities;
+            std::vector<Entity> entityMapping(staging.instance.metadata.writeComponents.size());
+            size_t count = std::count_if(stagingEntities.begin(), stagingEntities.end(), [](const Entity &e) {
+                return (bool)e;
+            });
+            if (count == 0) return entityMapping;
+            base->writeAccessedFlags[0] = true;
+
+            // Allocate a contiguous range of new entities and components
+            size_t nextIndex = instance.metadata.writeComponents.size();
+            size_t newSize = nextIndex + count;
+            if (newSize > std::numeric_limits<TECS_ENTITY_INDEX_TYPE>::max()) {
+                throw std::runtime_error("New entity index overflows type: " + std::to_string(newSize));
+            }
+            (AllocateComponents<AllComponentTypes>(count), ...);
+            instance.metadata.writeComponents.resize(newSize);
+            instance.metadata.validEntityIndexes.resize(newSize);
+
+            auto &validEntities = instance.metadata.writeValidEntities;
+            validEntities.reserve(validEntities.size() + count);
+            for (auto &stagingEntity : stagingEntities) {
+                if (!stagingEntity) continue;
+                Entity entity((TECS_ENTITY_INDEX_TYPE)nextIndex++, 1, (TECS_ENTITY_ECS_IDENTIFIER_TYPE)instance.ecsId);
+                entityMapping[stagingEntity.index] = entity;
+
+                auto &metadata = instance.metadata.writeComponents[entity.index];
+                metadata[0] = true;
+                metadata.generation = entity.generation;
+                instance.metadata.validEntityIndexes[entity.index] = validEntities.size();
+                validEntities.emplace_back(entity);
+            }
+
+            (SpliceComponents<AllComponentTypes>(staging, entityMapping), ...);
+
+            for (auto &stagingEntity : stagingEntities) {
+                if (stagingEntity) stagingEntity.Destroy(staging);
+            }
+            return entityMapping;
+        }
+
+        /**
+         * Creates count new entities, each with a copy of all of the prefab entity's components.
+         * The prefab can be any entity in this instance, including entities created in this transaction.
+         *
+         * The new entities are allocated as a contiguous range at the end of storage, rather than reusing free entity
+         * ids. Metadata is set in a single pass, and each component type is copied in bulk, so this is much faster
+         * than creating each entity with NewEntity() and Set<T>(). ADDED events are emitted for the new entities and
+         * components when this transaction is committed.
+         *
+         * Note: This function invalidates all references to components if a storage resize occurs.
+         */
+        inline std::vector<Entity> Instantiate(const Entity &prefab, size_t count) const {
+            static_assert(is_add_remove_allowed<LockType>(), "Lock does not have AddRemove permission.");
+            return InstantiateFrom(*this, prefab, count);
+        }
+
+        /**
+         * Creates count new entities, each with a copy of all of the components of a prefab entity stored in a
+         * separate prefab ECS instance. This allows prefabs to be kept out of this instance's entity lists.
+         * The prefab lock must have read access to all component types.
+         *
+         * Note: This function invalidates all references to components if a storage resize occurs.
+         */
+        template<typename... PrefabPermissions>
+        inline std::vector<Entity> Instantiate(const Lock<ECS, PrefabPermissions...> &prefabs,
+            const Entity &prefab,
+            size_t count) const {
+            static_assert(is_add_remove_allowed<LockType>(), "Lock does not have AddRemove permission.");
+            static_assert((is_read_allowed<AllComponentTypes, Lock<ECS, PrefabPermissions...>>() && ...),
+                "Prefab lock does not have read access to all components.");
+            return InstantiateFrom(prefabs, prefab, count);
+        }
+
         template<typename... Tn>
         inline bool Has() const {
             static_assert(all_global_components<Tn...>(), "Only global components can be accessed without an Entity");
@@ -219,7 +324,7 @@ namespace Tecs {
                     metadata[1 + instance.template GetComponentIndex<CompType>()] = true;
                     storage.writeComponents.resize(1);
                     // Reset value before allowing reading.
-                    storage.writeComponents[0] = {};
+                    component_recycler<CompType>::Recycle(storage.writeComponents[0]);
                 }
 #ifndef TECS_UNCHECKED_MODE
             } else if (!instance.template BitsetHas<CompType>(metadata)) {
@@ -247,6 +352,162 @@ namespace Tecs {
             return instance.template Storage<CompType>().readComponents[0];
         }
 
+        /**
+         * Calls callback(entity, component) with each entity's T component, equivalent to calling entity.Get<T>(lock)
+         * for each entity in the list. entities can be an EntityView, std::vector<Entity>, or any sized random access
+         * range of entities.
+         *
+         * Entity metadata and component storage are prefetched TECS_PREFETCH_DISTANCE entities ahead of access, hiding
+         * memory latency when following lists of entity references. All entities are validated up front, so an
+         * exception is thrown before any callbacks are made if an entity doesn't exist or has no T component.
+         * Unlike Entity::Get, GetMany never adds missing components, even with AddRemove permissions.
+         */
+        template<typename T, typename EntityList, typename Fn>
+        inline void GetMany(const EntityList &entities, Fn &&callback) const {
+            using CompType = std::remove_cv_t<T>;
+            using ReturnType = std::conditional_t<is_write_allowed<CompType, LockType>::value, T, const T>;
+            static_assert(is_read_allowed<CompType, LockType>(), "Component is not locked for reading.");
+            static_assert(is_write_allowed<CompType, LockType>() || std::is_const<ReturnType>(),
+                "Can't get non-const reference of read only Component.");
+            static_assert(!is_global_component<CompType>(), "Global components must be accessed through lock.Get()");
+
+            if constexpr (!std::is_const<ReturnType>()) base->template SetAccessFlag<CompType>(true);
+
+            auto &storage = instance.template Storage<CompType>();
+            auto &components = instance.template BitsetHas<CompType>(permissions) ? storage.writeComponents
+                                                                                   : storage.readComponents;
+            auto begin = entities.begin();
+            size_t count = entities.size();
+
+#ifndef TECS_UNCHECKED_MODE
+            auto &metadataList = permissions[0] ? instance.metadata.writeComponents : instance.metadata.readComponents;
+            for (size_t i = 0; i < count; i++) {
+                if constexpr (TECS_PREFETCH_DISTANCE > 0) {
+                    if (i + TECS_PREFETCH_DISTANCE < count) {
+                        auto aheadIndex = begin[i + TECS_PREFETCH_DISTANCE].index;
+                        if (aheadIndex < metadataList.size()) TECS_PREFETCH(&metadataList[aheadIndex]);
+                    }
+                }
+
+                const Entity &entity = begin[i];
+                if (entity.index >= metadataList.size()) {
+                    throw std::runtime_error("Entity does not exist: " + std::to_string(entity));
+                }
+                auto &metadata = metadataList[entity.index];
+                if (!metadata[0] || metadata.generation != entity.generation) {
+                    throw std::runtime_error("Entity does not exist: " + std::to_string(entity));
+                } else if (!instance.template BitsetHas<CompType>(metadata)) {
+                    throw std::runtime_error(
+                        "Entity does not have a component of type: " + std::string(typeid(CompType).name()));
+                }
+            }
+#endif
+
+            for (size_t i = 0; i < count; i++) {
+                if constexpr (TECS_PREFETCH_DISTANCE > 0) {
+                    if (i + TECS_PREFETCH_DISTANCE < count) {
+                        auto aheadIndex = begin[i + TECS_PREFETCH_DISTANCE].index;
+                        if (aheadIndex < components.size()) TECS_PREFETCH(&components[aheadIndex]);
+                    }
+                }
+
+                const Entity &entity = begin[i];
+                if constexpr (!std::is_const<ReturnType>()) storage.MarkChanged(entity.index);
+                callback(entity, static_cast<ReturnType &>(components[entity.index]));
+            }
+        }
+
+        /**
+         * Returns the entity's T component as it was committed ticksAgo commits of T before the start of this
+         * transaction. GetHistory<T>(entity, 0) is equivalent to entity.GetPrevious<T>(lock).
+         *
+         * T must have a history depth set with TECS_COMPONENT_HISTORY, and ticksAgo can be at most
+         * HistorySize<T>(). The entity must have a T component at the start of this transaction. History is stored by
+         * entity index, so values from before the entity gained its T component are either default constructed or
+         * belong to a previous entity at the same index.
+         */
+        template<typename T>
+        inline const T &GetHistory(const Entity &entity, size_t ticksAgo) const {
+            using CompType = std::remove_cv_t<T>;
+            static_assert(is_read_allowed<CompType, LockType>(), "Component is not locked for reading.");
+            static_assert(!is_global_component<CompType>(), "Global components do not store history.");
+            static_assert(component_history_depth<CompType>() > 0,
+                "Component has no history, set a depth with TECS_COMPONENT_HISTORY.");
+
+            if (ticksAgo == 0) return entity.GetPrevious<CompType>(*this);
+
+            auto &storage = instance.template Storage<CompType>();
+#ifndef TECS_UNCHECKED_MODE
+            if (!entity.Had<CompType>(*this)) {
+                throw std::runtime_error("Entity does not have a component of type: " +
+                                         std::string(typeid(CompType).name()));
+            }
+            if (ticksAgo > storage.historyCount) {
+                throw std::runtime_error("Component history only contains " + std::to_string(storage.historyCount) +
+                                         " commits: " + std::string(typeid(CompType).name()));
+            }
+#endif
+            auto &buffer = storage.HistoryBuffer(ticksAgo);
+#ifndef TECS_UNCHECKED_MODE
+            if (entity.index >= buffer.size()) {
+                throw std::runtime_error("Entity did not exist " + std::to_string(ticksAgo) +
+                                         " commits ago: " + std::to_string(entity));
+            }
+#endif
+            return buffer[entity.index];
+        }
+
+        /**
+         * Returns the number of previous commits of T available to GetHistory<T>(), up to T's history depth.
+         */
+        template<typename T>
+        inline size_t HistorySize() const {
+            using CompType = std::remove_cv_t<T>;
+            static_assert(is_read_allowed<CompType, LockType>(), "Component is not locked for reading.");
+            return instance.template Storage<CompType>().historyCount;
+        }
+
+        /**
+         * Returns the number of commits made to T's storage. This can be saved and later passed to
+         * EntitiesChangedSince<T>() to find the entities written since. If the value is unchanged, T hasn't been
+         * committed at all and can be skipped.
+         */
+        template<typename T>
+        inline size_t GetCommitTick() const {
+            using CompType = std::remove_cv_t<T>;
+            static_assert(is_read_allowed<CompType, LockType>(), "Component is not locked for reading.");
+            return instance.template Storage<CompType>().commitCount;
+        }
+
+        /**
+         * Returns the entities with a T component whose committed value was written after commit tick, where tick is
+         * a value previously returned by GetCommitTick<T>(). Entities are returned in index order, using the entity
+         * set as of the start of this transaction.
+         *
+         * T must have change tracking enabled with TECS_TRACK_CHANGES. Writes are counted whenever a mutable reference
+         * to the component is accessed, even if the value wasn't modified. The returned list is allocated from this
+         * transaction's Scratch() arena, and must not outlive the transaction.
+         */
+        template<typename T>
+        inline std::pmr::vector<Entity> EntitiesChangedSince(size_t tick) const {
+            using CompType = std::remove_cv_t<T>;
+            static_assert(is_read_allowed<CompType, LockType>(), "Component is not locked for reading.");
+            static_assert(!is_global_component<CompType>(), "Global components do not track changed entities.");
+            static_assert(is_change_tracked<CompType>(), "Component changes are not tracked, see TECS_TRACK_CHANGES.");
+
+            auto &storage = instance.template Storage<CompType>();
+            std::pmr::vector<Entity> changed(&Scratch());
+            if (tick >= storage.commitCount) return changed;
+
+            auto &changeTicks = storage.readChangeTicks;
+            for (auto &entity : storage.readValidEntities) {
+                if (entity.index < changeTicks.size() && changeTicks[entity.index] > tick) {
+                    changed.emplace_back(entity);
+                }
+            }
+            return changed;
+        }
+
         template<typename T>
         inline T &Set(T &value) const {
             static_assert(is_write_allowed<T, LockType>(), "Component is not locked for writing.");
@@ -300,7 +561,7 @@ namespace Tecs {
                 throw std::runtime_error("Missing global component of type: " + std::string(typeid(T).name()));
 #endif
             }
-            return instance.template Storage<T>().writeComponents[0] = T(std::forward<Args>(args)...);
+            return instance.template Storage<T>().WriteEmplace(0, std::forward<Args>(args)...);
         }
 
         template<typename... Tn>
@@ -349,6 +610,110 @@ namespace Tecs {
             return NewLockType(this->instance, this->base, {});
         }
 
+        /**
+         * Returns this transaction's ScratchArena for temporary allocations. The arena is taken from a per-thread
+         * pool when first requested, and all of its memory is recycled in bulk when the transaction ends.
+         *
+         * The arena should only be used by the thread that started the transaction.
+         */
+        inline ScratchArena &Scratch() const {
+            if (!base->scratch) base->scratch = ScratchArena::Acquire();
+            return *base->scratch;
+        }
+
+        /**
+         * Discards all changes made so far by this transaction, including entities and components added or removed,
+         * and resets the write storage to match the committed state. Nothing is committed for the discarded changes,
+         * and readers never observe them. Changes made after Abort() are committed as usual.
+         *
+         * Entity metadata, entity lists, and components marked with TECS_TRACK_WRITES() are reset in proportion to the
+         * number of entities modified, unless a large portion of the storage was written. Other components have their
+         * whole storage copied from the committed copy if any of their existing values were written, including by
+         * removing them, but only need to drop newly allocated values if they were only added.
+         *
+         * Writes can't be aborted for component types that have unpublished WriteDeferred changes, since they share
+         * the same write storage.
+         */
+        inline void Abort() const {
+#ifndef TECS_UNCHECKED_MODE
+            (
+                [&] {
+                    if (!instance.template BitsetHas<AllComponentTypes>(base->writeAccessedFlags)) return;
+                    if (instance.template Storage<AllComponentTypes>().unpublished) {
+                        throw std::runtime_error(
+                            "Can't abort writes to a component with unpublished deferred writes: " +
+                            std::string(typeid(AllComponentTypes).name()));
+                    }
+                }(),
+                ...);
+#endif
+            (AbortComponents<AllComponentTypes>(), ...);
+
+            if (base->writeAccessedFlags[0]) {
+                auto &metadata = instance.metadata;
+                metadata.DiscardWrites();
+                metadata.DiscardValidEntities();
+                instance.globalWriteMetadata = instance.globalReadMetadata;
+
+                // Free entities are only allocated past the end of the committed storage once the free list is empty,
+                // so the free list is restored by dropping those, and returning the entities taken from the front.
+                auto &freeEntities = instance.freeEntities;
+                while (!freeEntities.empty() && freeEntities.back().index >= metadata.readComponents.size()) {
+                    freeEntities.pop_back();
+                }
+                auto &taken = instance.takenFreeEntities;
+                for (auto it = taken.rbegin(); it != taken.rend(); it++) {
+                    if (it->index < metadata.readComponents.size()) freeEntities.emplace_front(*it);
+                }
+                taken.clear();
+            }
+            base->writeAccessedFlags.reset();
+        }
+
+        /**
+         * Returns true if another transaction is waiting to commit changes to any of the listed Component types,
+         * or to commit added or removed entities. The commit will be blocked until this transaction releases its
+         * read locks, either by ending, or by calling Yield().
+         */
+        template<typename... Tn>
+        inline bool CommitPending() const {
+            static_assert(std::conjunction<is_read_allowed<Tn, LockType>...>(), "Component is not locked for reading.");
+            // Only the leader of a lock group takes the commit lock.
+            return instance.metadata.CommitPending() ||
+                   (instance.template Storage<typename component_lock_group<Tn>::type>().CommitPending() || ...);
+        }
+
+        /**
+         * Briefly release and reacquire all read locks held by this transaction, allowing any pending commits to
+         * complete. Write locks are kept for the duration of the transaction.
+         *
+         * Long running read transactions can call this periodically when CommitPending() returns true, so that they
+         * don't block higher frequency writers.
+         *
+         * Note: This function invalidates all references to read-only components, as well as any EntityViews, since
+         * other transactions may commit changes or add and remove entities while the locks are released.
+         * This transaction must not be in use by other threads while yielding.
+         */
+        inline void Yield() const {
+            base->Yield();
+        }
+
+        /**
+         * Run this transaction's commit on a background thread, instead of on the thread that destroys the last Lock
+         * referencing it. Write locks remain held until the commit completes, so other writers will still wait for
+         * the changes to be committed. Read locks and unmodified write locks are released immediately.
+         *
+         * Returns a future that becomes ready once the changes are visible to new transactions. The future must not be
+         * waited on while this transaction is still active, since the commit can't start until it ends.
+         */
+        inline std::shared_future<void> AsyncCommit() const {
+            if (!base->asyncCommit) {
+                base->asyncCommit = std::make_shared<std::promise<void>>();
+                base->asyncCommitFuture = base->asyncCommit->get_future().share();
+            }
+            return base->asyncCommitFuture;
+        }
+
         long UseCount() const {
             return base.use_count();
         }
@@ -367,6 +732,117 @@ namespace Tecs {
             }
         }
 
+        template<typename T, typename StagingLockType>
+        inline void SpliceComponents(const StagingLockType &staging, const std::vector<Entity> &entityMapping) const {
+            if constexpr (!is_global_component<T>()) { // Ignore global components
+                auto &stagingStorage = staging.instance.template Storage<T>();
+                auto &storage = instance.template Storage<T>();
+                auto &validEntities = storage.writeValidEntities;
+                for (auto &stagingEntity : stagingStorage.writeValidEntities) {
+                    if (!stagingEntity) continue;
+                    auto &entity = entityMapping[stagingEntity.index];
+
+                    storage.writeComponents[entity.index] =
+                        std::move(stagingStorage.writeComponents[stagingEntity.index]);
+                    storage.MarkChanged(entity.index);
+                    instance.metadata.writeComponents[entity.index][1 + instance.template GetComponentIndex<T>()] =
+                        true;
+                    storage.validEntityIndexes[entity.index] = validEntities.size();
+                    validEntities.emplace_back(entity);
+                }
+            }
+        }
+
+        template<typename T>
+        inline void AbortComponents() const {
+            if (!instance.template BitsetHas<T>(base->writeAccessedFlags)) return;
+            auto &storage = instance.template Storage<T>();
+            if constexpr (is_global_component<T>()) {
+                storage.writeComponents = storage.readComponents;
+            } else {
+                storage.DiscardWrites();
+                if (base->writeAccessedFlags[0]) storage.DiscardValidEntities();
+            }
+        }
+
+        template<typename PrefabLockType>
+        inline std::vector<Entity> InstantiateFrom(const PrefabLockType &prefabs,
+            const Entity &prefab,
+            size_t count) const {
+            auto &prefabMetadataList = prefabs.permissions[0] ? prefabs.instance.metadata.writeComponents
+                                                              : prefabs.instance.metadata.readComponents;
+#ifndef TECS_UNCHECKED_MODE
+            if (prefab.index >= prefabMetadataList.size()) {
+                throw std::runtime_error("Entity does not exist: " + std::to_string(prefab));
+            }
+            auto &metadata = prefabMetadataList[prefab.index];
+            if (!metadata[0] || metadata.generation != prefab.generation) {
+                throw std::runtime_error("Entity does not exist: " + std::to_string(prefab));
+            }
+#endif
+            std::vector<Entity> entities;
+            if (count == 0) return entities;
+            base->writeAccessedFlags[0] = true;
+
+            // Copy the prefab's metadata, since it may be moved when storage is resized.
+            auto prefabMetadata = prefabMetadataList[prefab.index];
+
+            // Allocate a contiguous range of new entities and components
+            size_t firstIndex = instance.metadata.writeComponents.size();
+            size_t newSize = firstIndex + count;
+            if (newSize > std::numeric_limits<TECS_ENTITY_INDEX_TYPE>::max()) {
+                throw std::runtime_error("New entity index overflows type: " + std::to_string(newSize));
+            }
+            (AllocateComponents<AllComponentTypes>(count), ...);
+            instance.metadata.writeComponents.resize(newSize);
+            instance.metadata.validEntityIndexes.resize(newSize);
+
+            auto &validEntities = instance.metadata.writeValidEntities;
+            validEntities.reserve(validEntities.size() + count);
+            entities.reserve(count);
+            for (size_t index = firstIndex; index < newSize; index++) {
+                Entity entity((TECS_ENTITY_INDEX_TYPE)index, 1, (TECS_ENTITY_ECS_IDENTIFIER_TYPE)instance.ecsId);
+                entities.emplace_back(entity);
+
+                auto &metadata = instance.metadata.writeComponents[index];
+                metadata = prefabMetadata;
+                metadata.generation = entity.generation;
+                instance.metadata.validEntityIndexes[index] = validEntities.size();
+                validEntities.emplace_back(entity);
+            }
+
+            (InstantiateComponents<AllComponentTypes>(prefabs, prefab.index, prefabMetadata, entities), ...);
+            return entities;
+        }
+
+        template<typename T, typename PrefabLockType, typename MetadataType>
+        inline void InstantiateComponents(const PrefabLockType &prefabs,
+            size_t prefabIndex,
+            const MetadataType &prefabMetadata,
+            const std::vector<Entity> &entities) const {
+            if constexpr (!is_global_component<T>()) { // Ignore global components
+                if (!instance.template BitsetHas<T>(prefabMetadata)) return;
+
+                auto &prefabStorage = prefabs.instance.template Storage<T>();
+                auto &storage = instance.template Storage<T>();
+                // The prefab may be part of the same storage, but is always outside of the newly allocated range.
+                const T &value = prefabs.instance.template BitsetHas<T>(prefabs.permissions)
+                                     ? prefabStorage.writeComponents[prefabIndex]
+                                     : prefabStorage.readComponents[prefabIndex];
+
+                size_t firstIndex = entities.front().index;
+                std::fill_n(storage.writeComponents.begin() + firstIndex, entities.size(), value);
+
+                auto &validEntities = storage.writeValidEntities;
+                validEntities.reserve(validEntities.size() + entities.size());
+                for (auto &entity : entities) {
+                    storage.validEntityIndexes[entity.index] = validEntities.size();
+                    validEntities.emplace_back(entity);
+                    storage.MarkChanged(entity.index);
+                }
+            }
+        }
+
         template<typename T>
         inline void RemoveComponents(size_t index) const {
             if constexpr (!is_global_component<T>()) { // Ignore global components
@@ -376,10 +852,11 @@ namespace Tecs {
                     base->template SetAccessFlag<T>(true);
 
                     metadata[1 + instance.template GetComponentIndex<T>()] = false;
+                    instance.metadata.MarkChanged(index);
                     auto &compIndex = instance.template Storage<T>();
-                    compIndex.writeComponents[index] = {};
-                    size_t validIndex = compIndex.validEntityIndexes[index];
-                    compIndex.writeValidEntities[validIndex] = Entity();
+                    component_recycler<T>::Recycle(compIndex.writeComponents[index]);
+                    compIndex.MarkChanged(index);
+                    compIndex.RemoveValidEntity(index);
                 }
             }
         }
@@ -394,7 +871,7 @@ namespace Tecs {
                 base->template SetAccessFlag<T>(true);
 
                 metadata[1 + instance.template GetComponentIndex<T>()] = false;
-                instance.template Storage<T>().writeComponents[0] = {};
+                component_recycler<T>::Recycle(instance.template Storage<T>().writeComponents[0]);
             }
         }
 
@@ -402,6 +879,8 @@ namespace Tecs {
             (RemoveComponents<AllComponentTypes>(index), ...);
         }
 
+        template<typename...>
+        friend class ECS;
         template<typename, typename...>
         friend class Lock;
         template<typename, typename...>
@@ -417,6 +896,20 @@ namespace Tecs {
 
         const std::bitset<1 + sizeof...(AllComponentTypes)> readPermissions;
 
+        // Runtime permissions constructor used by ECS::StartTransaction(readPermissions, writePermissions)
+        inline DynamicLock(ECS &instance, std::shared_ptr<BaseTransaction<ECSType, AllComponentTypes...>> base,
+            const std::bitset<1 + sizeof...(AllComponentTypes)> &readPermissions,
+            const std::bitset<1 + sizeof...(AllComponentTypes)> &writePermissions)
+            : Lock<ECS, StaticPermissions...>(instance, base, writePermissions), readPermissions(readPermissions) {}
+
+        template<typename...>
+        friend class ECS;
+
+    public:
+        /**
+         * Returns the read permission bitset for a Lock type, as used by DynamicLock and ecs.StartTransaction().
+         * Bit 0 is always set, since all transactions can read entity metadata.
+         */
         template<typename LockType>
         static inline constexpr auto generateReadBitset() {
             std::bitset<1 + sizeof...(AllComponentTypes)> result;
@@ -437,6 +930,10 @@ namespace Tecs {
             return result;
         }
 
+        /**
+         * Returns the write permission bitset for a Lock type, as used by DynamicLock and ecs.StartTransaction().
+         * Bit 0 is set if the Lock type has AddRemove permissions.
+         */
         template<typename LockType>
         static inline constexpr auto generateWriteBitset() {
             std::bitset<1 + sizeof...(AllComponentTypes)> result;
@@ -457,7 +954,6 @@ namespace Tecs {
             return result;
         }
 
-    public:
         template<typename LockType>
         DynamicLock(const LockType &lock)
             : Lock<ECS, StaticPermissions...>(lock), readPermissions(generateReadBitset<LockType>()) {}
@@ -8,6 +8,7 @@
 #include <thread>
 #include <tuple>
 #include <type_traits>
+#include <utility>
 
 namespace Tecs {
     enum class EventType {
@@ -25,6 +26,8 @@ namespace Tecs {
         ComponentEvent() : type(EventType::INVALID), entity(), component() {}
         ComponentEvent(EventType type, const Entity &entity, const T &component)
             : type(type), entity(entity), component(component) {}
+        ComponentEvent(EventType type, const Entity &entity, T &&component)
+            : type(type), entity(entity), component(std::move(component)) {}
     };
 
     struct EntityEvent {
@@ -56,7 +59,7 @@ namespace Tecs {
         bool Poll(Lock<ECSType> lock, EventType &eventOut) const {
             auto eventList = eventListWeak.lock();
             if (eventList && !eventList->empty()) {
-                eventOut = eventList->front();
+                eventOut = std::move(eventList->front());
                 eventList->pop_front();
                 return true;
             }
@@ -27,6 +27,10 @@ namespace Tecs {
      * // Allow read and write access to all components, as well as adding and removing entities and components.
      * Transaction<ECSType, AddRemove> transaction2 = ecs.NewTransaction<AddRemove>();
      *
+     * // Allow read and write access to C components, without making the changes visible to readers on commit.
+     * // Deferred writes are kept for the next writer, and are made visible by a normal commit, or ecs.Publish<C>().
+     * Transaction<ECSType, WriteDeferred<C>> transaction3 = ecs.NewTransaction<WriteDeferred<C>>();
+     *
      * // Reference a transaction's permissions (or a subset of them) by using the Lock type.
      * Lock<ECSType, AddRemove> lockAll = transaction2;
      * Lock<ECSType, Read<A>, Write<B>> lockWriteB = transaction1;
@@ -41,6 +45,8 @@ namespace Tecs {
     template<typename... LockedTypes>
     struct Write {};
     struct WriteAll {};
+    template<typename... LockedTypes>
+    struct WriteDeferred {};
     struct AddRemove {};
 
     /**
@@ -91,6 +97,146 @@ namespace Tecs {
         static constexpr char value[] = (ComponentName);                                                               \
     };
 
+    /**
+     * When a component is removed or newly added to an entity, its storage slot is reset before being reused.
+     * By default the slot is assigned a default constructed value, which frees any memory owned by the old component.
+     *
+     * Components that own heap allocations (such as std::vector or std::string members) can instead be reset in place
+     * so that their capacity is kept and reused by the next entity, avoiding allocations during AddRemove transactions.
+     * The component recycler type trait can be set using the following pattern:
+     *
+     * template<>
+     * struct Tecs::component_recycler<ComponentType> {
+     *     static void Recycle(ComponentType &value) {
+     *         value.clear();
+     *     }
+     * };
+     *
+     * Or alternatively with the helper macro, which calls value.clear():
+     *
+     * TECS_RECYCLE_COMPONENT(ComponentType);
+     *
+     * Note: This must be defined in the root namespace only, and the recycled value must be equivalent to a default
+     * constructed component.
+     *
+     * Recycling keeps memory in place, but doesn't change where it is allocated from. Components can also allocate
+     * their heap memory from a pool per component type with a ComponentAllocator, defined in Tecs_component_pool.hh.
+     */
+    template<typename T>
+    struct component_recycler {
+        static void Recycle(T &value) {
+            value = {};
+        }
+    };
+
+#define TECS_RECYCLE_COMPONENT(ComponentType)                                                                          \
+    template<>                                                                                                         \
+    struct Tecs::component_recycler<ComponentType> {                                                                   \
+        static void Recycle(ComponentType &value) {                                                                    \
+            value.clear();                                                                                             \
+        }                                                                                                              \
+    };
+
+    /**
+     * Components can keep a history of their previous committed values, readable with lock.GetHistory<T>().
+     * By default only the current and previous values are stored (the depth is 0).
+     *
+     * With a history depth of N, the last N read buffers replaced by a commit are kept instead of being overwritten.
+     * Buffers are rotated at commit time rather than copied, so the added cost is the memory for N extra copies of
+     * the component storage. The history depth type trait can be set using the following pattern:
+     *
+     * template<>
+     * struct Tecs::component_history_depth<ComponentType> : std::integral_constant<size_t, 8> {};
+     *
+     * Or alternatively with the helper macro:
+     *
+     * TECS_COMPONENT_HISTORY(ComponentType, 8);
+     *
+     * Note: This must be defined in the root namespace only.
+     */
+    template<typename T>
+    struct component_history_depth : std::integral_constant<size_t, 0> {};
+
+#define TECS_COMPONENT_HISTORY(ComponentType, Depth)                                                                   \
+    template<>                                                                                                         \
+    struct Tecs::component_history_depth<ComponentType> : std::integral_constant<size_t, (Depth)> {};
+
+    /**
+     * Components can track which entities were written by each commit, so that consumers such as GPU uploads or
+     * network replication can find the entities that changed since they last looked with
+     * lock.EntitiesChangedSince<T>(tick). Tracking costs a counter per entity, updated each time a mutable reference to
+     * the component is accessed. The change tracking type trait can be set using the following pattern:
+     *
+     * template<>
+     * struct Tecs::is_change_tracked<ComponentType> : std::true_type {};
+     *
+     * Or alternatively with the helper macro:
+     *
+     * TECS_TRACK_CHANGES(ComponentType);
+     *
+     * Note: This must be defined in the root namespace only.
+     */
+    template<typename T>
+    struct is_change_tracked : std::false_type {};
+
+#define TECS_TRACK_CHANGES(ComponentType)                                                                              \
+    template<>                                                                                                         \
+    struct Tecs::is_change_tracked<ComponentType> : std::true_type {};
+
+    /**
+     * Components can record which entities were written by the current transaction, so that lock.Abort() only needs to
+     * reset those values instead of copying the whole committed storage. Tracking costs a counter per entity, checked
+     * each time a mutable reference to the component is accessed, so it is only worth enabling for large components
+     * that are aborted often. The write tracking type trait can be set using the following pattern:
+     *
+     * template<>
+     * struct Tecs::is_write_tracked<ComponentType> : std::true_type {};
+     *
+     * Or alternatively with the helper macro:
+     *
+     * TECS_TRACK_WRITES(ComponentType);
+     *
+     * Note: This must be defined in the root namespace only.
+     */
+    template<typename T>
+    struct is_write_tracked : std::false_type {};
+
+#define TECS_TRACK_WRITES(ComponentType)                                                                               \
+    template<>                                                                                                         \
+    struct Tecs::is_write_tracked<ComponentType> : std::true_type {};
+
+    /**
+     * Components that are always accessed together can share a single lock by joining a lock group, so that wide
+     * transactions acquire and commit one lock per group instead of one per component. A group is named by one of its
+     * components, the group leader, whose lock is used by every member of the group. The lock group type trait can be
+     * set using the following pattern:
+     *
+     * template<>
+     * struct Tecs::component_lock_group<ComponentType> { using type = LeaderComponentType; };
+     *
+     * Or alternatively with the helper macro:
+     *
+     * TECS_LOCK_GROUP(ComponentType, LeaderComponentType);
+     *
+     * Locking any member of a group locks the whole group, so a transaction writing one member will block commits to
+     * the others until it ends. Lock contention stats and performance traces are recorded on the group leader.
+     *
+     * Note: This must be defined in the root namespace only.
+     */
+    template<typename T>
+    struct component_lock_group {
+        using type = T;
+    };
+
+#define TECS_LOCK_GROUP(ComponentType, LeaderComponentType)                                                            \
+    template<>                                                                                                         \
+    struct Tecs::component_lock_group<ComponentType> {                                                                 \
+        static_assert(std::is_same<typename Tecs::component_lock_group<LeaderComponentType>::type,                     \
+                          LeaderComponentType>(),                                                                      \
+            "A lock group leader can't be a member of another lock group");                                            \
+        using type = LeaderComponentType;                                                                              \
+    };
+
     // contains<T, Un...>::value is true if T is part of the set Un...
     template<typename T, typename... Un>
     struct contains : std::disjunction<std::is_same<T, Un>...> {};
@@ -109,6 +255,8 @@ namespace Tecs {
     struct is_write_allowed : std::false_type {};
     template<typename Lock>
     struct is_add_remove_allowed : std::false_type {};
+    template<typename T, typename Lock>
+    struct is_write_deferred : std::false_type {};
 
     // Lock<Permissions...> and DynamicLock<Permissions...> specializations
     // clang-format off
@@ -140,6 +288,15 @@ namespace Tecs {
     struct is_add_remove_allowed<const DynamicLock<ECSType, Permissions...>> : contains<AddRemove, Permissions...> {};
     // clang-format on
 
+    // Writes are only deferred if no other permission requires T to be committed
+    template<typename T, typename Permission>
+    struct is_write_committed
+        : std::conjunction<is_write_allowed<T, Permission>, std::negation<is_write_deferred<T, Permission>>> {};
+    template<typename T, typename ECSType, typename... Permissions>
+    struct is_write_deferred<T, Lock<ECSType, Permissions...>>
+        : std::conjunction<std::disjunction<is_write_deferred<T, Permissions>...>,
+              std::negation<std::disjunction<is_write_committed<T, Permissions>...>>> {};
+
     // Check SubLock <= Lock for component type T
     template<typename T, typename SubLock, typename Lock>
     struct is_lock_subset
@@ -161,6 +318,14 @@ namespace Tecs {
     template<typename T, typename... LockedTypes>
     struct is_write_allowed<T, Write<LockedTypes...>> : contains<T, LockedTypes...> {};
 
+    // WriteDeferred<LockedTypes...> specialization
+    template<typename T, typename... LockedTypes>
+    struct is_read_allowed<T, WriteDeferred<LockedTypes...>> : contains<T, LockedTypes...> {};
+    template<typename T, typename... LockedTypes>
+    struct is_write_allowed<T, WriteDeferred<LockedTypes...>> : contains<T, LockedTypes...> {};
+    template<typename T, typename... LockedTypes>
+    struct is_write_deferred<T, WriteDeferred<LockedTypes...>> : contains<T, LockedTypes...> {};
+
     // WriteAll specialization
     template<typename T>
     struct is_read_allowed<T, WriteAll> : std::true_type {};
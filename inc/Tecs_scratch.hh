@@ -0,0 +1,138 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Size of the first memory block allocated by a ScratchArena. Later blocks grow to fit larger allocations.
+#ifndef TECS_SCRATCH_BLOCK_SIZE
+    #define TECS_SCRATCH_BLOCK_SIZE 65536
+#endif
+
+namespace Tecs {
+    /**
+     * A ScratchArena is a bump allocator for temporary allocations made during a transaction, accessed through
+     * lock.Scratch(). It implements std::pmr::memory_resource, so it can be used with any std::pmr container:
+     *
+     * std::pmr::vector<Tecs::Entity> candidates(&lock.Scratch());
+     *
+     * Deallocation is a no-op. All memory is released at once when the transaction ends, and the arena is returned to
+     * a per-thread pool so its memory blocks can be reused by the next transaction without touching the heap.
+     * Anything allocated from the arena must be destroyed before the transaction ends.
+     *
+     * A ScratchArena is not thread-safe, and should only be used by the thread that started the transaction.
+     */
+    class ScratchArena : public std::pmr::memory_resource {
+    public:
+        ScratchArena() {}
+        // Delete copy constructor
+        ScratchArena(const ScratchArena &) = delete;
+
+        /**
+         * Release all allocations made from this arena.
+         * If more than one block was allocated, they are replaced with a single block large enough to fit them all.
+         */
+        inline void Reset() {
+            if (blocks.size() > 1) {
+                size_t totalSize = 0;
+                for (auto &block : blocks) {
+                    totalSize += block.size;
+                }
+                blocks.clear();
+                AddBlock(totalSize);
+            }
+            offset = 0;
+            bytesAllocated = 0;
+        }
+
+        /**
+         * Returns the number of bytes allocated from this arena since it was last reset.
+         */
+        inline size_t BytesAllocated() const {
+            return bytesAllocated;
+        }
+
+        /**
+         * Returns the total size of the memory blocks owned by this arena.
+         */
+        inline size_t Capacity() const {
+            size_t capacity = 0;
+            for (auto &block : blocks) {
+                capacity += block.size;
+            }
+            return capacity;
+        }
+
+        /**
+         * Returns an arena from the calling thread's pool, or a new arena if the pool is empty.
+         */
+        static inline std::unique_ptr<ScratchArena> Acquire() {
+            auto &pool = ThreadPool();
+            if (pool.empty()) return std::make_unique<ScratchArena>();
+            auto arena = std::move(pool.back());
+            pool.pop_back();
+            return arena;
+        }
+
+        /**
+         * Reset an arena and return it to the calling thread's pool.
+         */
+        static inline void Release(std::unique_ptr<ScratchArena> &&arena) {
+            arena->Reset();
+            ThreadPool().emplace_back(std::move(arena));
+        }
+
+    protected:
+        void *do_allocate(size_t bytes, size_t alignment) override {
+            if (!blocks.empty()) {
+                auto &block = blocks.back();
+                void *ptr = block.data.get() + offset;
+                size_t space = block.size - offset;
+                if (std::align(alignment, bytes, ptr, space)) {
+                    offset = block.size - space + bytes;
+                    bytesAllocated += bytes;
+                    return ptr;
+                }
+            }
+
+            size_t lastSize = blocks.empty() ? (size_t)TECS_SCRATCH_BLOCK_SIZE / 2 : blocks.back().size;
+            auto &block = AddBlock(std::max(lastSize * 2, bytes + alignment));
+            void *ptr = block.data.get();
+            size_t space = block.size;
+            std::align(alignment, bytes, ptr, space);
+            offset = block.size - space + bytes;
+            bytesAllocated += bytes;
+            return ptr;
+        }
+
+        void do_deallocate(void *, size_t, size_t) override {}
+
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+            return this == &other;
+        }
+
+    private:
+        struct Block {
+            std::unique_ptr<std::byte[]> data;
+            size_t size;
+        };
+
+        inline Block &AddBlock(size_t size) {
+            offset = 0;
+            return blocks.emplace_back(Block{std::unique_ptr<std::byte[]>(new std::byte[size]), size});
+        }
+
+        static inline std::vector<std::unique_ptr<ScratchArena>> &ThreadPool() {
+            static thread_local std::vector<std::unique_ptr<ScratchArena>> pool;
+            return pool;
+        }
+
+        std::vector<Block> blocks;
+        size_t offset = 0;
+        size_t bytesAllocated = 0;
+    };
+}; // namespace Tecs
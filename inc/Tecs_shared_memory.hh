@@ -0,0 +1,469 @@
+#pragma once
+
+#include "Tecs_entity.hh"
+#include "Tecs_permissions.hh"
+#include "nonstd/span.hpp"
+
+#ifdef _WIN32
+    #error "Tecs_shared_memory.hh requires POSIX shared memory"
+#endif
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <type_traits>
+#include <unistd.h>
+#include <utility>
+
+#ifndef TECS_SPINLOCK_RETRY_YIELD
+    #define TECS_SPINLOCK_RETRY_YIELD 10
+#endif
+
+static_assert(std::atomic_uint32_t::is_always_lock_free, "std::atomic_uint32_t must be lock-free to be process-shared");
+
+namespace Tecs {
+    /**
+     * Reader/publisher lock word stored inside a shared memory segment, guarding one buffer of a SharedMemoryMirror.
+     *
+     * Any number of readers can hold the lock at once, and a publisher can only lock it while there are no readers.
+     * Neither side ever waits on the other: readers may belong to other processes that are slow or have crashed, so
+     * the publisher must never block on them.
+     */
+    struct SharedMemoryLock {
+        inline bool TryReadLock() {
+            uint32_t current = readers;
+            while (current != READER_LOCKED) {
+                if (readers.compare_exchange_weak(current,
+                        current + 1,
+                        std::memory_order_acquire,
+                        std::memory_order_relaxed)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        inline void ReadUnlock() {
+            uint32_t current = readers;
+            if (current == READER_FREE || current == READER_LOCKED) {
+                throw std::runtime_error("SharedMemoryLock::ReadUnlock called outside of ReadLock");
+            }
+            readers.fetch_sub(1, std::memory_order_release);
+        }
+
+        /**
+         * Acquire exclusive access for publishing if there are no active readers. Returns false immediately otherwise.
+         */
+        inline bool TryPublishLock() {
+            uint32_t current = READER_FREE;
+            return readers.compare_exchange_strong(current,
+                READER_LOCKED,
+                std::memory_order_acquire,
+                std::memory_order_relaxed);
+        }
+
+        inline void PublishUnlock() {
+            uint32_t current = READER_LOCKED;
+            if (!readers.compare_exchange_strong(current, READER_FREE, std::memory_order_release)) {
+                throw std::runtime_error("SharedMemoryLock::PublishUnlock called outside of PublishLock");
+            }
+        }
+
+    private:
+        static const uint32_t READER_FREE = 0;
+        static const uint32_t READER_LOCKED = UINT32_MAX;
+
+        std::atomic_uint32_t readers = 0;
+    };
+
+    /**
+     * A SharedMemoryMirror is a snapshot exporter: it publishes a copy of an ECS's entities and components into a
+     * named POSIX shared memory segment, so that other processes can read them in place without serialization.
+     *
+     * It is not a process-shared ECS. The ECS's own storage and locks stay in process-private memory, and readers in
+     * other processes never take part in its transactions. Each publish copies every mirrored component, so its cost
+     * grows with the number of entities rather than with the number of changes, and readers only see the state as of
+     * the last publish.
+     *
+     * The segment holds a fixed capacity of entities, laid out as a header with lock words followed by two buffers,
+     * each with a metadata entry per entity index, the list of valid entities, and then a densely indexed array for each
+     * component type. Only trivially copyable components can be mirrored, since their bytes must be meaningful in
+     * another address space.
+     *
+     * TryPublish() is called by the process owning the ECS from inside a transaction with read access to all mirrored
+     * components. Other processes Open() the same segment and use StartRead() to hold a shared read lock on the most
+     * recently published buffer while they inspect it. The publisher writes into whichever buffer has no readers, so
+     * publishing never waits for readers, and never extends the ECS transaction. If readers are holding both buffers,
+     * the publish is skipped.
+     */
+    template<typename... Tn>
+    class SharedMemoryMirror {
+        static_assert(sizeof...(Tn) > 0, "SharedMemoryMirror requires at least one component type");
+        static_assert(sizeof...(Tn) < 64, "SharedMemoryMirror supports at most 63 component types");
+        static_assert(std::conjunction<std::is_trivially_copyable<Tn>...>(),
+            "Shared memory components must be trivially copyable");
+        static_assert(!contains_global_components<Tn...>(), "Global components can't be mirrored to shared memory");
+        static_assert(((alignof(Tn) <= 64) && ...), "Shared memory components must have an alignment of 64 or less");
+
+    public:
+        struct EntityMetadata {
+            uint64_t components; // Bit 0 is set if the entity exists, bit 1 + N if it has component N
+            TECS_ENTITY_GENERATION_TYPE generation;
+        };
+
+        /**
+         * Holds a shared read lock on the most recently published buffer until destroyed, with read access to the
+         * mirror's metadata and components Un...
+         *
+         * Read locks should be short lived. A buffer can't be published into while it is read locked, so a reader that
+         * holds its lock across more than one publish forces the publisher to reuse the other buffer, and readers
+         * holding both buffers cause publishes to be skipped.
+         */
+        template<typename... Un>
+        class ReadLock {
+        public:
+            static_assert((contains<Un, Tn...>() && ...), "Component is not part of this SharedMemoryMirror");
+
+            ReadLock(ReadLock &&other) noexcept
+                : mirror(std::exchange(other.mirror, nullptr)), bufferIndex(other.bufferIndex) {}
+            ReadLock(const ReadLock &) = delete;
+            ReadLock &operator=(const ReadLock &) = delete;
+
+            ~ReadLock() {
+                if (mirror) mirror->header->buffers[bufferIndex].lock.ReadUnlock();
+            }
+
+            /**
+             * Returns the list of entities that existed when the buffer was published.
+             */
+            inline nonstd::span<const Entity> Entities() const {
+                return nonstd::span<const Entity>(Buffer().validEntities, BufferHeader().validEntityCount);
+            }
+
+            inline bool Exists(const Entity &entity) const {
+                if (entity.index >= BufferHeader().entitySlots) return false;
+                const auto &metadata = Buffer().metadata[entity.index];
+                return (metadata.components & 1) && metadata.generation == entity.generation;
+            }
+
+            template<typename T>
+            inline bool Has(const Entity &entity) const {
+                static_assert(contains<T, Un...>(), "ReadLock does not have read permissions for component");
+                return Exists(entity) && (Buffer().metadata[entity.index].components & ComponentBit<T>());
+            }
+
+            template<typename T>
+            inline const T &Get(const Entity &entity) const {
+                static_assert(contains<T, Un...>(), "ReadLock does not have read permissions for component");
+#ifndef TECS_UNCHECKED_MODE
+                if (!Has<T>(entity)) {
+                    throw std::runtime_error(
+                        "SharedMemoryMirror::ReadLock::Get: Entity does not have the requested component");
+                }
+#endif
+                return Buffer().template ComponentData<T>()[entity.index];
+            }
+
+            /**
+             * Returns the number of successful publishes up to and including the one being read, starting at 1 for
+             * the first TryPublish().
+             */
+            inline size_t PublishCount() const {
+                return BufferHeader().publishCount;
+            }
+
+        private:
+            ReadLock(const SharedMemoryMirror &mirror) : mirror(&mirror) {
+                // The current buffer is only write locked while it is being republished because the other buffer is
+                // held by readers, which is bounded by the time taken to publish.
+                int retry = 0;
+                while (true) {
+                    bufferIndex = mirror.header->current.load(std::memory_order_acquire);
+                    if (mirror.header->buffers[bufferIndex].lock.TryReadLock()) return;
+                    if (retry++ > TECS_SPINLOCK_RETRY_YIELD) {
+                        retry = 0;
+                        std::this_thread::yield();
+                    }
+                }
+            }
+
+            inline const auto &Buffer() const {
+                return mirror->buffers[bufferIndex];
+            }
+
+            inline const auto &BufferHeader() const {
+                return mirror->header->buffers[bufferIndex];
+            }
+
+            const SharedMemoryMirror *mirror;
+            uint32_t bufferIndex = 0;
+
+            friend class SharedMemoryMirror;
+        };
+
+        /**
+         * Create a new shared memory segment with room for entity indexes up to capacity. Any existing segment with the
+         * same name is unlinked first; processes that already mapped it will keep seeing its last published state.
+         *
+         * The segment is unlinked again when the returned mirror is destroyed.
+         */
+        static SharedMemoryMirror Create(const std::string &name, size_t capacity) {
+            return SharedMemoryMirror(name, true, capacity);
+        }
+
+        /**
+         * Open an existing shared memory segment created by another process with the same component types.
+         */
+        static SharedMemoryMirror Open(const std::string &name) {
+            return SharedMemoryMirror(name, false, 0);
+        }
+
+        SharedMemoryMirror(SharedMemoryMirror &&other) noexcept
+            : name(std::move(other.name)), owner(std::exchange(other.owner, false)),
+              mapping(std::exchange(other.mapping, nullptr)), mappingSize(std::exchange(other.mappingSize, 0)),
+              header(other.header), buffers(other.buffers) {}
+        SharedMemoryMirror(const SharedMemoryMirror &) = delete;
+        SharedMemoryMirror &operator=(const SharedMemoryMirror &) = delete;
+
+        ~SharedMemoryMirror() {
+            if (mapping) munmap(mapping, mappingSize);
+            if (owner) shm_unlink(name.c_str());
+        }
+
+        /**
+         * Copy the entities and mirrored components visible to lock into shared memory, without waiting on readers.
+         * Every valid entity is copied on each call, not just the ones changed since the last publish.
+         *
+         * The copy is written into the buffer not currently being read, and then made current for new readers. If that
+         * buffer is still held by a reader, the current buffer is rewritten in place instead. Returns false without
+         * publishing if both buffers are read locked, or if another thread is already publishing.
+         */
+        template<typename LockType>
+        bool TryPublish(const LockType &lock) {
+            static_assert((is_read_allowed<Tn, LockType>() && ...),
+                "Lock does not have read permissions for all mirrored components");
+
+            auto entities = lock.Entities();
+            size_t slots = 0;
+            for (auto &entity : entities) {
+                // Entities removed in an uncommitted AddRemove transaction leave invalid placeholders
+                if (entity.Exists(lock)) slots = std::max(slots, (size_t)entity.index + 1);
+            }
+            if (slots > header->capacity) {
+                throw std::runtime_error("SharedMemoryMirror::TryPublish: Entity index exceeds mirror capacity: " +
+                                         std::to_string(slots - 1));
+            }
+
+            uint32_t expected = 0;
+            if (!header->publishing.compare_exchange_strong(expected, 1, std::memory_order_acquire)) return false;
+
+            uint32_t current = header->current.load(std::memory_order_relaxed);
+            uint32_t target = 1 - current;
+            if (!header->buffers[target].lock.TryPublishLock()) {
+                target = current;
+                if (!header->buffers[target].lock.TryPublishLock()) {
+                    header->publishing.store(0, std::memory_order_release);
+                    return false;
+                }
+            }
+
+            auto &buffer = buffers[target];
+            auto &bufferHeader = header->buffers[target];
+            std::fill(buffer.metadata,
+                buffer.metadata + std::max(slots, (size_t)bufferHeader.entitySlots),
+                EntityMetadata{0, 0});
+            bufferHeader.entitySlots = slots;
+            size_t count = 0;
+            for (auto &entity : entities) {
+                if (!entity.Exists(lock)) continue;
+                buffer.metadata[entity.index] = EntityMetadata{1, entity.generation};
+                buffer.validEntities[count++] = entity;
+            }
+            bufferHeader.validEntityCount = count;
+            (PublishComponent<Tn>(lock, buffer), ...);
+            bufferHeader.publishCount = ++header->publishCount;
+
+            bufferHeader.lock.PublishUnlock();
+            header->current.store(target, std::memory_order_release);
+            header->publishing.store(0, std::memory_order_release);
+            return true;
+        }
+
+        template<typename... Un>
+        inline ReadLock<Un...> StartRead() const {
+            return ReadLock<Un...>(*this);
+        }
+
+        inline size_t Capacity() const {
+            return header->capacity;
+        }
+
+    private:
+        static const uint64_t MAGIC = 0x5465637353686d32; // "TecsShm2"
+
+        struct BufferHeader {
+            SharedMemoryLock lock;
+            uint64_t entitySlots;
+            uint64_t validEntityCount;
+            uint64_t publishCount;
+        };
+
+        struct Header {
+            uint64_t magic;
+            uint64_t layoutHash;
+            uint64_t capacity;
+            uint64_t totalSize;
+            uint64_t publishCount;
+            // Index of the most recently published buffer
+            std::atomic_uint32_t current;
+            // Set while a publisher is writing, so that only one publisher is active at once
+            std::atomic_uint32_t publishing;
+            std::array<BufferHeader, 2> buffers;
+        };
+
+        // Region pointers into one of the segment's buffers, valid within this process's mapping
+        struct Buffer {
+            EntityMetadata *metadata = nullptr;
+            Entity *validEntities = nullptr;
+            std::array<char *, sizeof...(Tn)> components = {};
+
+            template<typename T>
+            inline T *ComponentData() const {
+                return reinterpret_cast<T *>(components[ComponentSlot<T>()]);
+            }
+        };
+
+        // Used to detect processes opening a segment with a different set of components
+        static constexpr uint64_t LayoutHash() {
+            uint64_t hash = 14695981039346656037ull;
+            for (uint64_t value : {(uint64_t)sizeof(Entity),
+                     (uint64_t)sizeof(EntityMetadata),
+                     (uint64_t)sizeof(Header),
+                     (uint64_t)sizeof(Tn)...,
+                     (uint64_t)alignof(Tn)...}) {
+                hash = (hash ^ value) * 1099511628211ull;
+            }
+            return hash;
+        }
+
+        static constexpr size_t Align(size_t offset) {
+            return (offset + 63) & ~(size_t)63;
+        }
+
+        template<typename T>
+        static constexpr size_t ComponentSlot() {
+            constexpr bool matches[] = {std::is_same<T, Tn>()...};
+            for (size_t i = 0; i < sizeof...(Tn); i++) {
+                if (matches[i]) return i;
+            }
+            return sizeof...(Tn);
+        }
+
+        template<typename T>
+        static constexpr uint64_t ComponentBit() {
+            return (uint64_t)1 << (1 + ComponentSlot<T>());
+        }
+
+        SharedMemoryMirror(const std::string &name, bool create, size_t capacity) : name(name), owner(create) {
+            int fd;
+            if (create) {
+                shm_unlink(name.c_str());
+                fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+            } else {
+                fd = shm_open(name.c_str(), O_RDWR, 0);
+            }
+            if (fd < 0) {
+                owner = false;
+                throw std::runtime_error(
+                    std::string("SharedMemoryMirror failed to open (") + std::strerror(errno) + "): " + name);
+            }
+
+            // Release anything acquired so far before reporting an error, since the destructor won't run.
+            auto fail = [&](const std::string &message) {
+                if (fd >= 0) close(fd);
+                if (mapping) munmap(mapping, mappingSize);
+                if (owner) shm_unlink(name.c_str());
+                throw std::runtime_error("SharedMemoryMirror " + message + ": " + name);
+            };
+
+            if (create) {
+                mappingSize = Layout(capacity);
+                if (ftruncate(fd, mappingSize) != 0) {
+                    fail(std::string("failed to resize (") + std::strerror(errno) + ")");
+                }
+            } else {
+                struct stat info;
+                if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(Header)) fail("segment is not initialized");
+                mappingSize = info.st_size;
+            }
+
+            mapping = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (mapping == MAP_FAILED) {
+                mapping = nullptr;
+                fail(std::string("failed to map (") + std::strerror(errno) + ")");
+            }
+            close(fd);
+            fd = -1;
+
+            header = static_cast<Header *>(mapping);
+            if (create) {
+                new (header) Header{0, LayoutHash(), capacity, mappingSize, 0, {0}, {0}, {}};
+                std::atomic_thread_fence(std::memory_order_release);
+                header->magic = MAGIC;
+            } else if (header->magic != MAGIC || header->layoutHash != LayoutHash()) {
+                fail("segment has an incompatible layout");
+            } else if (Layout(header->capacity) != header->totalSize || header->totalSize > mappingSize) {
+                fail("segment is truncated");
+            }
+            Layout(header->capacity);
+        }
+
+        // Computes the offset of each region for the given capacity, and returns the total size of the segment.
+        // Region pointers are only updated once the segment has been mapped.
+        size_t Layout(size_t capacity) {
+            char *base = static_cast<char *>(mapping);
+            size_t offset = Align(sizeof(Header));
+            size_t sizes[] = {sizeof(Tn)...};
+            for (auto &buffer : buffers) {
+                if (base) buffer.metadata = reinterpret_cast<EntityMetadata *>(base + offset);
+                offset = Align(offset + sizeof(EntityMetadata) * capacity);
+                if (base) buffer.validEntities = reinterpret_cast<Entity *>(base + offset);
+                offset = Align(offset + sizeof(Entity) * capacity);
+                for (size_t i = 0; i < sizeof...(Tn); i++) {
+                    if (base) buffer.components[i] = base + offset;
+                    offset = Align(offset + sizes[i] * capacity);
+                }
+            }
+            return offset;
+        }
+
+        template<typename T, typename LockType>
+        inline void PublishComponent(const LockType &lock, const Buffer &buffer) {
+            T *data = buffer.template ComponentData<T>();
+            for (auto &entity : lock.template EntitiesWith<T>()) {
+                if (!entity.template Has<T>(lock)) continue;
+                buffer.metadata[entity.index].components |= ComponentBit<T>();
+                std::memcpy(&data[entity.index], &entity.template Get<const T>(lock), sizeof(T));
+            }
+        }
+
+        std::string name;
+        bool owner = false;
+        void *mapping = nullptr;
+        size_t mappingSize = 0;
+
+        Header *header = nullptr;
+        std::array<Buffer, 2> buffers = {};
+    };
+}; // namespace Tecs
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace Tecs {
+    /**
+     * Lock contention and commit counters kept by each ComponentIndex.
+     *
+     * Counters are only updated with relaxed atomic operations when a lock is contended or a transaction commits, so
+     * the uncontended lock path is unaffected. They can be read from any thread at any time without taking a lock.
+     */
+    struct ComponentIndexStats {
+        // Number of times each lock was contended, either by waiting for it or by failing a non-blocking attempt
+        std::atomic_size_t readLockWaits = 0;
+        std::atomic_size_t writeLockWaits = 0;
+        std::atomic_size_t commitLockWaits = 0;
+        // Number of valid entities as of the last commit
+        std::atomic_size_t validEntityCount = 0;
+        // Number of values copied from the read buffer back into the write buffer by the last commit
+        std::atomic_size_t lastCommitCopies = 0;
+    };
+
+    /**
+     * A snapshot of the stats for a single Component type, or for entity metadata.
+     */
+    struct ComponentStats {
+        std::string name;
+        bool global = false;
+        size_t validEntityCount = 0;
+        size_t commitCount = 0;
+        size_t lastCommitCopies = 0;
+        size_t readLockWaits = 0;
+        size_t writeLockWaits = 0;
+        size_t commitLockWaits = 0;
+        // Events queued for observers of this Component type, as of the last AddRemove commit
+        size_t observerBacklog = 0;
+    };
+
+    /**
+     * A snapshot of an ECS instance's stats, returned by ecs.GetStats().
+     *
+     * Each counter is read atomically, but the snapshot as a whole is not synchronized with running transactions, so
+     * counters from different Component types may have been read on either side of a commit.
+     */
+    struct ECSStats {
+        ComponentStats entities;
+        std::vector<ComponentStats> components;
+
+        std::string ToJson() const {
+            std::stringstream out;
+            out << "{\"entities\":";
+            WriteJson(out, entities);
+            out << ",\"components\":[";
+            for (size_t i = 0; i < components.size(); i++) {
+                if (i > 0) out << ",";
+                WriteJson(out, components[i]);
+            }
+            out << "]}";
+            return out.str();
+        }
+
+        std::string ToString() const {
+            std::stringstream out;
+            out << "name\tglobal\tentities\tcommits\tcopies\treadWaits\twriteWaits\tcommitWaits\tbacklog" << std::endl;
+            WriteText(out, entities);
+            for (auto &component : components) {
+                WriteText(out, component);
+            }
+            return out.str();
+        }
+
+    private:
+        static void WriteJson(std::ostream &out, const ComponentStats &stats) {
+            out << "{\"name\":\"";
+            for (char ch : stats.name) {
+                if (ch == '"' || ch == '\\') {
+                    out << '\\' << ch;
+                } else if ((unsigned char)ch >= 0x20) {
+                    out << ch;
+                }
+            }
+            out << "\",\"global\":" << (stats.global ? "true" : "false");
+            out << ",\"validEntityCount\":" << stats.validEntityCount;
+            out << ",\"commitCount\":" << stats.commitCount;
+            out << ",\"lastCommitCopies\":" << stats.lastCommitCopies;
+            out << ",\"readLockWaits\":" << stats.readLockWaits;
+            out << ",\"writeLockWaits\":" << stats.writeLockWaits;
+            out << ",\"commitLockWaits\":" << stats.commitLockWaits;
+            out << ",\"observerBacklog\":" << stats.observerBacklog << "}";
+        }
+
+        static void WriteText(std::ostream &out, const ComponentStats &stats) {
+            out << stats.name << "\t" << (stats.global ? "yes" : "no") << "\t" << stats.validEntityCount << "\t"
+                << stats.commitCount << "\t" << stats.lastCommitCopies << "\t" << stats.readLockWaits << "\t"
+                << stats.writeLockWaits << "\t" << stats.commitLockWaits << "\t" << stats.observerBacklog
+                << std::endl;
+        }
+    };
+}; // namespace Tecs
@@ -2,6 +2,7 @@
 
 #include "Tecs_entity.hh"
 #include "Tecs_observer.hh"
+#include "Tecs_stats.hh"
 #ifdef TECS_ENABLE_PERFORMANCE_TRACING
     #include "Tecs_tracing.hh"
 #endif
@@ -10,19 +11,109 @@
     #include <tracy/Tracy.hpp>
 #endif
 
+#include <algorithm>
+#include <array>
 #include <atomic>
 #include <cstddef>
+#include <memory>
 #include <set>
 #include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #ifndef TECS_SPINLOCK_RETRY_YIELD
     #define TECS_SPINLOCK_RETRY_YIELD 10
 #endif
 
+// Number of entities ahead of the current one to prefetch when accessing components in bulk. 0 disables prefetching.
+#ifndef TECS_PREFETCH_DISTANCE
+    #define TECS_PREFETCH_DISTANCE 8
+#endif
+
+#ifndef TECS_PREFETCH
+    #if defined(__GNUC__) || defined(__clang__)
+        #define TECS_PREFETCH(address) __builtin_prefetch(address)
+    #elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        #include <xmmintrin.h>
+        #define TECS_PREFETCH(address) _mm_prefetch((const char *)(address), _MM_HINT_T0)
+    #else
+        #define TECS_PREFETCH(address)
+    #endif
+#endif
+
 static_assert(ATOMIC_INT_LOCK_FREE == 2, "std::atomic_int is not lock-free");
 
 namespace Tecs {
+    /**
+     * A committed read buffer, which can be shared with instances created by ECS::Fork() without copying it.
+     *
+     * Read buffers are only replaced while holding the commit lock, and a buffer shared with another instance is
+     * never modified. Instead, committing to a shared buffer moves the new values into a separate allocation, and the
+     * previous buffer is left to the instances still referencing it.
+     */
+    template<typename E>
+    class SharedBuffer {
+    public:
+        SharedBuffer() : buffer(std::make_shared<std::vector<E>>()) {}
+
+        inline operator std::vector<E> &() {
+            return *buffer;
+        }
+        inline operator const std::vector<E> &() const {
+            return *buffer;
+        }
+        inline const std::vector<E> &operator*() const {
+            return *buffer;
+        }
+
+        inline E &operator[](size_t index) {
+            return (*buffer)[index];
+        }
+        inline const E &operator[](size_t index) const {
+            return (*buffer)[index];
+        }
+        inline size_t size() const {
+            return buffer->size();
+        }
+        inline auto begin() const {
+            return buffer->cbegin();
+        }
+        inline auto end() const {
+            return buffer->cend();
+        }
+
+        /**
+         * Returns true if this buffer is also referenced by another instance.
+         */
+        inline bool IsShared() const {
+            if (buffer.use_count() > 1) return true;
+            // Other instances may have just released the buffer, make sure their reads have completed.
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return false;
+        }
+
+        /**
+         * Exchange this buffer's values with other. If this buffer is shared, its values are left unmodified for the
+         * other references, and other is left empty instead.
+         */
+        inline void swap(std::vector<E> &other) {
+            if (IsShared()) {
+                buffer = std::make_shared<std::vector<E>>(std::move(other));
+                other.clear();
+            } else {
+                buffer->swap(other);
+            }
+        }
+
+        inline void swap(SharedBuffer<E> &other) {
+            buffer.swap(other.buffer);
+        }
+
+    private:
+        std::shared_ptr<std::vector<E>> buffer;
+    };
+
     template<typename T>
     class ComponentIndex {
     public:
@@ -33,9 +124,7 @@ namespace Tecs {
          * ReadUnlock() must be called exactly once after reading has completed.
          */
         inline bool ReadLock(bool block = true) {
-#ifdef TECS_ENABLE_PERFORMANCE_TRACING
-            bool tracedWait = false;
-#endif
+            bool waited = false;
 #if defined(TECS_ENABLE_TRACY) && defined(TECS_TRACY_INCLUDE_LOCKS)
             bool runAfterLockShared = false;
             if (block) {
@@ -69,18 +158,20 @@ namespace Tecs {
                 }
 
                 if (!block) {
+                    stats.readLockWaits.fetch_add(1, std::memory_order_relaxed);
 #if defined(TECS_ENABLE_TRACY) && defined(TECS_TRACY_INCLUDE_LOCKS)
                     tracyRead.AfterTryLockShared(false);
 #endif
                     return false;
                 }
 
+                if (!waited) {
+                    stats.readLockWaits.fetch_add(1, std::memory_order_relaxed);
 #ifdef TECS_ENABLE_PERFORMANCE_TRACING
-                if (!tracedWait) {
                     traceInfo.Trace(TraceEvent::Type::ReadLockWait);
-                    tracedWait = true;
-                }
 #endif
+                    waited = true;
+                }
 
                 if (retry++ > TECS_SPINLOCK_RETRY_YIELD) {
                     retry = 0;
@@ -124,9 +215,7 @@ namespace Tecs {
          * This function will block if another writer has already started.
          */
         inline bool WriteLock(bool block = true) {
-#ifdef TECS_ENABLE_PERFORMANCE_TRACING
-            bool tracedWait = false;
-#endif
+            bool waited = false;
 #if defined(TECS_ENABLE_TRACY) && defined(TECS_TRACY_INCLUDE_LOCKS)
             bool runAfterLock = false;
             if (block) {
@@ -158,18 +247,20 @@ namespace Tecs {
                 }
 
                 if (!block) {
+                    stats.writeLockWaits.fetch_add(1, std::memory_order_relaxed);
 #if defined(TECS_ENABLE_TRACY) && defined(TECS_TRACY_INCLUDE_LOCKS)
                     tracyWrite.AfterTryLock(false);
 #endif
                     return false;
                 }
 
+                if (!waited) {
+                    stats.writeLockWaits.fetch_add(1, std::memory_order_relaxed);
 #ifdef TECS_ENABLE_PERFORMANCE_TRACING
-                if (!tracedWait) {
                     traceInfo.Trace(TraceEvent::Type::WriteLockWait);
-                    tracedWait = true;
-                }
 #endif
+                    waited = true;
+                }
 
                 if (retry++ > TECS_SPINLOCK_RETRY_YIELD) {
                     retry = 0;
@@ -192,9 +283,7 @@ namespace Tecs {
          * A commit lock can only be acquired once per write lock, and must be followed by a WriteUnlock().
          */
         inline void CommitLock() {
-#ifdef TECS_ENABLE_PERFORMANCE_TRACING
-            bool tracedWait = false;
-#endif
+            bool waited = false;
 #if defined(TECS_ENABLE_TRACY) && defined(TECS_TRACY_INCLUDE_LOCKS)
             bool runAfterLock = tracyRead.BeforeLock();
 #endif
@@ -225,12 +314,13 @@ namespace Tecs {
                     }
                 }
 
+                if (!waited) {
+                    stats.commitLockWaits.fetch_add(1, std::memory_order_relaxed);
 #ifdef TECS_ENABLE_PERFORMANCE_TRACING
-                if (!tracedWait) {
                     traceInfo.Trace(TraceEvent::Type::CommitLockWait);
-                    tracedWait = true;
-                }
 #endif
+                    waited = true;
+                }
 
                 if (retry++ > TECS_SPINLOCK_RETRY_YIELD) {
                     retry = 0;
@@ -277,10 +367,28 @@ namespace Tecs {
 #endif
         }
 
+        /**
+         * Returns true if a writer is waiting for readers to unlock so that it can commit.
+         * New read locks will block until the commit has completed.
+         */
+        inline bool CommitPending() const {
+            return writer.load(std::memory_order_relaxed) == WRITER_COMMIT;
+        }
+
+        /**
+         * Forget the indexes modified by the current writer. This is done by WriteUnlock(), and must be done separately
+         * for components sharing a lock group leader's lock, since they are never unlocked themselves.
+         */
+        inline void ClearDirtyIndexes() {
+            ClearDirtyValues();
+            removedValidEntities.clear();
+        }
+
         inline void WriteUnlock() {
 #ifdef TECS_ENABLE_PERFORMANCE_TRACING
             traceInfo.Trace(TraceEvent::Type::WriteUnlock);
 #endif
+            ClearDirtyIndexes();
 
             // Unlock read and write copies
             uint32_t current = readers;
@@ -327,10 +435,214 @@ namespace Tecs {
 #endif
 
         inline static constexpr size_t GetBytesPerEntity() {
-            return sizeof(T) * 2 + sizeof(Entity) * 2 + sizeof(size_t);
+            return sizeof(T) * (2 + component_history_depth<T>::value) + sizeof(Entity) * 2 + sizeof(size_t);
         }
 
     private:
+        /**
+         * Replace the write buffer value at index with a new component constructed from args.
+         *
+         * A single argument of type T is assigned directly so that any existing allocations can be reused.
+         * Otherwise the new value is constructed once from the forwarded arguments and moved into place.
+         */
+        template<typename... Args>
+        inline T &WriteEmplace(size_t index, Args &&...args) {
+            if constexpr (sizeof...(Args) == 1 && std::conjunction<std::is_same<T, std::decay_t<Args>>...>()) {
+                return (writeComponents[index] = ... = std::forward<Args>(args));
+            } else {
+                return writeComponents[index] = T(std::forward<Args>(args)...);
+            }
+        }
+
+        /**
+         * Share the committed read storage of another instance's index, without copying it. The write storage is
+         * filled in by the first writer, see PrepareWriteStorage(). The caller must hold a read lock on source.
+         */
+        inline void ShareReadStorage(const ComponentIndex<T> &source) {
+            readComponents = source.readComponents;
+            readValidEntities = source.readValidEntities;
+            commitCount = source.commitCount.load();
+            if constexpr (is_change_tracked<T>()) readChangeTicks = source.readChangeTicks;
+            stats.validEntityCount.store(source.stats.validEntityCount.load(std::memory_order_relaxed),
+                std::memory_order_relaxed);
+            writeStoragePending = true;
+        }
+
+        /**
+         * Copy the read storage into the write storage if it hasn't been filled in since ShareReadStorage().
+         * Must be called while holding the write lock, before any writes are made.
+         */
+        inline void PrepareWriteStorage() {
+            if (!writeStoragePending) return;
+            writeComponents = readComponents;
+            if constexpr (is_change_tracked<T>()) writeChangeTicks = readChangeTicks;
+            ResetValidEntities();
+            writeStoragePending = false;
+        }
+
+        /**
+         * Reset the write valid entity list and its indexes to match the read valid entity list.
+         */
+        inline void ResetValidEntities() {
+            removedValidEntities.clear();
+            writeValidEntities = readValidEntities;
+            validEntityIndexes.resize(readComponents.size());
+            for (size_t i = 0; i < readValidEntities.size(); i++) {
+                validEntityIndexes[readValidEntities[i].index] = i;
+            }
+        }
+
+        /**
+         * Remove the entity at index from the write valid entity list. Its slot is left empty until the next commit
+         * rebuilds the list, and is recorded so DiscardValidEntities() can restore it.
+         */
+        inline void RemoveValidEntity(size_t index) {
+            size_t validIndex = validEntityIndexes[index];
+            if (validIndex < readValidEntities.size()) removedValidEntities.emplace_back(validIndex);
+            writeValidEntities[validIndex] = Entity();
+        }
+
+        /**
+         * Reset the write valid entity list and its indexes to match the read valid entity list, discarding all
+         * entities added or removed by the current writer.
+         *
+         * Entities are only ever appended to the write list, or removed by clearing their slot, so this only needs to
+         * truncate the list and restore the removed slots.
+         */
+        inline void DiscardValidEntities() {
+            writeValidEntities.resize(readValidEntities.size());
+            for (auto &validIndex : removedValidEntities) {
+                auto &entity = readValidEntities[validIndex];
+                writeValidEntities[validIndex] = entity;
+                validEntityIndexes[entity.index] = validIndex;
+            }
+            removedValidEntities.clear();
+            validEntityIndexes.resize(readComponents.size());
+        }
+
+        /**
+         * Record that the write buffer value at index was modified, and will become visible with the next commit.
+         *
+         * If T is write tracked, each modified index is recorded once so that DiscardWrites() only needs to reset
+         * them. Tracking stops once more than roughly 1/6 of the storage has been modified, since it is then faster to
+         * reset the whole buffer. Indexes past the end of the read buffer are discarded by truncating the write
+         * buffer, so they are never recorded.
+         */
+        inline void MarkChanged(size_t index) {
+            if constexpr (is_write_tracked<T>()) {
+                if (!dirtyOverflow && index < readComponents.size()) {
+                    if (index >= dirtyStamps.size()) dirtyStamps.resize(writeComponents.size());
+                    if (dirtyStamps[index] != dirtyStamp) {
+                        if (dirtyIndexes.size() < writeComponents.size() / 6) {
+                            dirtyStamps[index] = dirtyStamp;
+                            dirtyIndexes.emplace_back(index);
+                        } else {
+                            dirtyOverflow = true;
+                        }
+                    }
+                }
+            } else if (index < readComponents.size()) {
+                dirtyOverflow = true;
+            }
+            if constexpr (is_change_tracked<T>()) {
+                if (index >= writeChangeTicks.size()) writeChangeTicks.resize(writeComponents.size());
+                writeChangeTicks[index] = commitCount + 1;
+            }
+        }
+
+        /**
+         * Record that all write buffer values were modified, and will become visible with the next commit.
+         */
+        inline void MarkAllChanged() {
+            dirtyOverflow = true;
+            if constexpr (is_change_tracked<T>()) {
+                writeChangeTicks.assign(writeComponents.size(), commitCount + 1);
+            }
+        }
+
+        /**
+         * Reset the write buffer to match the read buffer, discarding all changes made by the current writer.
+         * Any components allocated by the writer past the end of the read buffer are removed.
+         *
+         * If T isn't write tracked, the whole buffer is copied if any committed value was modified. Otherwise only the
+         * modified values are reset, unless a large portion of the buffer was modified.
+         */
+        inline void DiscardWrites() {
+            if (dirtyOverflow) {
+                writeComponents = readComponents;
+                if constexpr (is_change_tracked<T>()) writeChangeTicks = readChangeTicks;
+            } else {
+                writeComponents.resize(readComponents.size());
+                if constexpr (is_change_tracked<T>()) {
+                    if (writeChangeTicks.size() > readChangeTicks.size()) {
+                        writeChangeTicks.resize(readChangeTicks.size());
+                    }
+                }
+                for (auto &index : dirtyIndexes) {
+                    if (index >= readComponents.size()) continue;
+                    writeComponents[index] = readComponents[index];
+                    if constexpr (is_change_tracked<T>()) {
+                        if (index < writeChangeTicks.size()) {
+                            writeChangeTicks[index] = index < readChangeTicks.size() ? readChangeTicks[index] : 0;
+                        }
+                    }
+                }
+            }
+            ClearDirtyValues();
+        }
+
+        /**
+         * Forget the values modified by the current writer, keeping any removed valid entities.
+         */
+        inline void ClearDirtyValues() {
+            dirtyOverflow = false;
+            if constexpr (is_write_tracked<T>()) {
+                dirtyIndexes.clear();
+                // Start a new stamp so that the next writer records each index again.
+                if (++dirtyStamp == 0) {
+                    std::fill(dirtyStamps.begin(), dirtyStamps.end(), 0);
+                    dirtyStamp = 1;
+                }
+            }
+        }
+
+        /**
+         * Swap the read and write buffers to make written values visible to readers.
+         * Must be called while holding the commit lock.
+         *
+         * If the read buffer is shared with a forked instance, the write buffer is left empty instead, and must be
+         * refilled from the read buffer.
+         */
+        inline void CommitSwap() {
+            RotateHistory();
+            readComponents.swap(writeComponents);
+            if constexpr (is_change_tracked<T>()) readChangeTicks.swap(writeChangeTicks);
+            commitCount++;
+        }
+
+        /**
+         * Move the read buffer into the history ring before a commit swap, replacing the oldest entry.
+         * The oldest history buffer becomes the read buffer, and is swapped with the new values in the write buffer.
+         *
+         * Must be called while holding the commit lock.
+         */
+        inline void RotateHistory() {
+            static constexpr size_t depth = component_history_depth<T>::value;
+            if constexpr (depth > 0) {
+                historyHead = (historyHead + 1) % depth;
+                history[historyHead].swap(readComponents);
+                if (historyCount < depth) historyCount++;
+            }
+        }
+
+        /**
+         * Returns the read buffer as of ticksAgo commits before the current one, where 1 <= ticksAgo <= historyCount.
+         */
+        inline const std::vector<T> &HistoryBuffer(size_t ticksAgo) const {
+            static constexpr size_t depth = component_history_depth<T>::value;
+            return *history[(historyHead + depth + 1 - ticksAgo) % depth];
+        }
+
         // Lock states
         static const uint32_t WRITER_FREE = 0;
         static const uint32_t WRITER_LOCKED = 1;
@@ -341,12 +653,42 @@ namespace Tecs {
         std::atomic_uint32_t readers = 0;
         std::atomic_uint32_t writer = 0;
 
-        std::vector<T> readComponents;
+        SharedBuffer<T> readComponents;
         std::vector<T> writeComponents;
-        std::vector<Entity> readValidEntities;
+        SharedBuffer<Entity> readValidEntities;
         std::vector<Entity> writeValidEntities;
         std::vector<size_t> validEntityIndexes; // Indexes into writeValidEntities
-
+        // Slots of readValidEntities removed from writeValidEntities by the current writer
+        std::vector<size_t> removedValidEntities;
+
+        // True if the write buffer contains deferred writes that have not been committed to the read buffer
+        bool unpublished = false;
+        // True if the read storage is shared from another instance, and the write storage hasn't been filled in yet
+        bool writeStoragePending = false;
+        // Incremented each time the read buffer is replaced by a commit
+        std::atomic_size_t commitCount = 0;
+        // Lock contention and commit counters, readable from any thread without locking
+        ComponentIndexStats stats;
+        // Write buffer indexes modified by the current writer, used to discard writes when a transaction is aborted.
+        // Only used if T is write tracked. An index is recorded when its stamp doesn't match the current dirtyStamp.
+        std::vector<size_t> dirtyIndexes;
+        // Set if the whole write buffer must be reset to discard writes. If T isn't write tracked, this is set as soon
+        // as any value in the read buffer's range is modified.
+        bool dirtyOverflow = false;
+        std::vector<uint32_t> dirtyStamps;
+        uint32_t dirtyStamp = 1;
+
+        // The commit count at which each entity's value was last written, only used if T is change tracked
+        SharedBuffer<size_t> readChangeTicks;
+        std::vector<size_t> writeChangeTicks;
+
+        // Ring of previously committed read buffers, with the most recent at historyHead
+        std::array<SharedBuffer<T>, component_history_depth<T>::value> history;
+        size_t historyHead = 0;
+        size_t historyCount = 0;
+
+        template<typename...>
+        friend class ECS;
         template<typename, typename...>
         friend class Lock;
         template<typename, typename...>
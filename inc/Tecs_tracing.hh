@@ -44,11 +44,21 @@ namespace Tecs {
             CommitLock,
             CommitUnlock,
             WriteUnlock,
+            // Commit phases, where the End event's value is the number of entities or events processed
+            PreCommitStart,
+            PreCommitEnd,
+            ObserverCommitStart,
+            ObserverCommitEnd,
+            SwapStart,
+            SwapEnd,
+            CopyBackStart,
+            CopyBackEnd,
         };
 
         Type type = Type::Invalid;
         std::thread::id thread;
         std::chrono::steady_clock::time_point time;
+        size_t value = 0;
     };
 
     static inline std::ostream &operator<<(std::ostream &out, const TraceEvent::Type &t) {
@@ -65,6 +75,14 @@ namespace Tecs {
             "CommitLock",
             "CommitUnlock",
             "WriteUnlock",
+            "PreCommitStart",
+            "PreCommitEnd",
+            "ObserverCommitStart",
+            "ObserverCommitEnd",
+            "SwapStart",
+            "SwapEnd",
+            "CopyBackStart",
+            "CopyBackEnd",
         };
         return out << eventTypeNames[(size_t)t];
     }
@@ -91,14 +109,14 @@ namespace Tecs {
         }
 
         void SaveToCSV(std::ostream &out) {
-            out << "Transaction Event,Transaction Thread Id,Transaction TimeNs";
-            out << ",Metadata Event,Metadata Thread Id,Metadata TimeNs";
+            out << "Transaction Event,Transaction Thread Id,Transaction TimeNs,Transaction Value";
+            out << ",Metadata Event,Metadata Thread Id,Metadata TimeNs,Metadata Value";
             if (componentEvents.size() != componentNames.size()) {
                 throw std::runtime_error("Trying to save a trace with mismatched array sizes");
             }
             for (size_t i = 0; i < componentEvents.size(); i++) {
                 auto &name = componentNames[i];
-                out << "," << name << " Event," << name << " Thread Id," << name << " TimeNs";
+                out << "," << name << " Event," << name << " Thread Id," << name << " TimeNs," << name << " Value";
             }
             out << std::endl;
 
@@ -107,44 +125,46 @@ namespace Tecs {
                 done = true;
 
                 if (row < transactionEvents.size()) {
-                    auto &event = transactionEvents[row];
-                    out << event.type << "," << GetThreadName(event.thread) << ",";
-                    out << std::chrono::duration_cast<std::chrono::nanoseconds>(event.time.time_since_epoch()).count();
+                    WriteCSVEvent(out, transactionEvents[row]);
                     done = false;
                 } else {
-                    out << ",,";
+                    out << ",,,";
                 }
 
                 if (row < metadataEvents.size()) {
-                    auto &event = metadataEvents[row];
-                    out << "," << event.type << "," << GetThreadName(event.thread) << ",";
-                    out << std::chrono::duration_cast<std::chrono::nanoseconds>(event.time.time_since_epoch()).count();
+                    out << ",";
+                    WriteCSVEvent(out, metadataEvents[row]);
                     done = false;
                 } else {
-                    out << ",,,";
+                    out << ",,,,";
                 }
 
                 for (auto &events : componentEvents) {
                     if (row < events.size()) {
-                        auto &event = events[row];
-                        out << "," << event.type << "," << GetThreadName(event.thread) << ",";
-                        out << std::chrono::duration_cast<std::chrono::nanoseconds>(event.time.time_since_epoch())
-                                   .count();
+                        out << ",";
+                        WriteCSVEvent(out, events[row]);
                         done = false;
                     } else {
-                        out << ",,,";
+                        out << ",,,,";
                     }
                 }
                 out << std::endl;
             }
         }
+
+    private:
+        void WriteCSVEvent(std::ostream &out, const TraceEvent &event) {
+            out << event.type << "," << GetThreadName(event.thread) << ",";
+            out << std::chrono::duration_cast<std::chrono::nanoseconds>(event.time.time_since_epoch()).count();
+            out << "," << event.value;
+        }
     };
 
     class TraceInfo {
     public:
         TraceInfo() : traceEnabled(false), nextEventIndex(0), events(TECS_PERFORMANCE_TRACING_MAX_EVENTS) {}
 
-        inline void Trace(TraceEvent::Type eventType) {
+        inline void Trace(TraceEvent::Type eventType, size_t value = 0) {
             if (traceEnabled) {
                 auto index = nextEventIndex++;
                 if (index < events.size()) {
@@ -152,6 +172,7 @@ namespace Tecs {
                     event.time = std::chrono::steady_clock::now();
                     event.thread = std::this_thread::get_id();
                     event.type = eventType;
+                    event.value = value;
                 }
             }
         }
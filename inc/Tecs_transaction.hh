@@ -3,6 +3,7 @@
 #include "Tecs_entity.hh"
 #include "Tecs_observer.hh"
 #include "Tecs_permissions.hh"
+#include "Tecs_scratch.hh"
 #ifdef TECS_ENABLE_PERFORMANCE_TRACING
     #include "Tecs_tracing.hh"
 #endif
@@ -15,8 +16,18 @@
 #include <array>
 #include <atomic>
 #include <bitset>
+#include <condition_variable>
 #include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
 
 namespace Tecs {
 #ifndef TECS_HEADER_ONLY
@@ -31,6 +42,60 @@ namespace Tecs {
     extern std::atomic_size_t nextTransactionId;
 #endif
 
+    /**
+     * A background thread for running Transaction commits queued by Lock::AsyncCommit().
+     *
+     * Commits are run in the order they were queued. The thread is started when the first commit is queued, and any
+     * queued commits are completed before the thread exits.
+     */
+    class AsyncCommitThread {
+    public:
+        AsyncCommitThread() {}
+        // Delete copy constructor
+        AsyncCommitThread(const AsyncCommitThread &) = delete;
+
+        ~AsyncCommitThread() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                exiting = true;
+            }
+            condition.notify_all();
+            if (thread.joinable()) thread.join();
+        }
+
+        inline void Push(std::function<void()> &&commit) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                queue.emplace_back(std::move(commit));
+                if (!thread.joinable()) thread = std::thread(&AsyncCommitThread::Run, this);
+            }
+            condition.notify_all();
+        }
+
+    private:
+        void Run() {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (true) {
+                condition.wait(lock, [this] {
+                    return exiting || !queue.empty();
+                });
+                if (queue.empty()) return;
+
+                auto commit = std::move(queue.front());
+                queue.pop_front();
+                lock.unlock();
+                commit();
+                lock.lock();
+            }
+        }
+
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::deque<std::function<void()>> queue;
+        bool exiting = false;
+        std::thread thread;
+    };
+
     /**
      * When a Transaction is started, the relevant parts of the ECS are locked based on the Transactions Permissons.
      * The permissions can then be referenced by passing around Lock objects.
@@ -59,6 +124,7 @@ namespace Tecs {
         BaseTransaction(const BaseTransaction &) = delete;
 
         virtual ~BaseTransaction() {
+            if (scratch) ScratchArena::Release(std::move(scratch));
 #ifndef TECS_HEADER_ONLY
             auto start = activeTransactions.begin();
             activeTransactionsCount = std::remove(start, start + activeTransactionsCount, instance.ecsId) - start;
@@ -66,6 +132,9 @@ namespace Tecs {
         }
 
     protected:
+        // Release and reacquire all read locks held by this transaction. Write locks are kept.
+        virtual void Yield() = 0;
+
         ECSType<AllComponentTypes...> &instance;
 #ifndef TECS_HEADER_ONLY
         size_t transactionId;
@@ -73,83 +142,110 @@ namespace Tecs {
 
         std::bitset<1 + sizeof...(AllComponentTypes)> writeAccessedFlags;
 
-        template<typename T>
-        inline void SetAccessFlag(bool value) {
-            writeAccessedFlags[1 + instance.template GetComponentIndex<T>()] = value;
+        // Locks held by this transaction, indexed by the metadata and lock group leader bits of a permission bitset
+        std::bitset<1 + sizeof...(AllComponentTypes)> readLocks;
+        std::bitset<1 + sizeof...(AllComponentTypes)> writeLocks;
+
+        // Acquired from the thread's pool by the first call to Lock::Scratch()
+        std::unique_ptr<ScratchArena> scratch;
+
+        // Set by Lock::AsyncCommit() to run the commit on the instance's AsyncCommitThread
+        std::shared_ptr<std::promise<void>> asyncCommit;
+        std::shared_future<void> asyncCommitFuture;
+
+        using CommitFunc = void (*)(ECSType<AllComponentTypes...> &,
+            const std::bitset<1 + sizeof...(AllComponentTypes)> &);
+
+        /**
+         * Runs the commit function for this transaction's write accesses, or queues it on the instance's
+         * AsyncCommitThread if AsyncCommit() was requested and there is something to commit.
+         */
+        inline void CommitOrQueue(CommitFunc commit) {
+            if (asyncCommit && writeAccessedFlags.any()) {
+                auto &instance = this->instance;
+                auto flags = writeAccessedFlags;
+                auto promise = asyncCommit;
+                instance.asyncCommitThread.Push([commit, &instance, flags, promise] {
+                    try {
+                        commit(instance, flags);
+                        promise->set_value();
+                    } catch (...) {
+                        promise->set_exception(std::current_exception());
+                    }
+                });
+            } else {
+                commit(instance, writeAccessedFlags);
+                if (asyncCommit) asyncCommit->set_value();
+            }
         }
 
-        template<typename, typename...>
-        friend class Lock;
-        friend struct Entity;
-    };
-
-    template<typename... AllComponentTypes, typename... Permissions>
-    class Transaction<ECS<AllComponentTypes...>, Permissions...> : public BaseTransaction<ECS, AllComponentTypes...> {
-    private:
-        using LockType = Lock<ECS<AllComponentTypes...>, Permissions...>;
-        using EntityMetadata = typename ECS<AllComponentTypes...>::EntityMetadata;
-        using FlatPermissions = typename FlattenPermissions<LockType, AllComponentTypes...>::type;
-
-#ifdef TECS_ENABLE_TRACY
-        static inline const auto tracyCtx = []() -> const tracy::SourceLocationData * {
-            static const tracy::SourceLocationData srcloc{"TecsTransaction",
-                FlatPermissions::Name(),
-                __FILE__,
-                __LINE__,
-                0};
-            return &srcloc;
-        };
-    #if defined(TRACY_HAS_CALLSTACK) && defined(TRACY_CALLSTACK)
-        tracy::ScopedZone tracyZone{tracyCtx(), TRACY_CALLSTACK, true};
-    #else
-        tracy::ScopedZone tracyZone{tracyCtx(), true};
-    #endif
-#endif
-
-    public:
-        inline Transaction(ECS<AllComponentTypes...> &instance) : BaseTransaction<ECS, AllComponentTypes...>(instance) {
-#ifdef TECS_ENABLE_PERFORMANCE_TRACING
-            TECS_EXTERNAL_TRACE_TRANSACTION_STARTING(FlatPermissions::Name());
-            instance.transactionTrace.Trace(TraceEvent::Type::TransactionStart);
-#endif
-#ifdef TECS_ENABLE_TRACY
-            ZoneNamedN(tracyScope, "StartTransaction", true);
-#endif
+        /**
+         * Returns the locks covering a set of permissions, where each component in a lock group is replaced by its
+         * group leader. Bit 0 for the entity metadata is unchanged.
+         */
+        static inline std::bitset<1 + sizeof...(AllComponentTypes)> GroupLocks(
+            const std::bitset<1 + sizeof...(AllComponentTypes)> &permissions) {
+            static constexpr std::array<size_t, 1 + sizeof...(AllComponentTypes)> lockIndexes = {0,
+                (1 + ECSType<AllComponentTypes...>::template GetComponentIndex<
+                         typename component_lock_group<AllComponentTypes>::type>())...};
+            std::bitset<1 + sizeof...(AllComponentTypes)> locks;
+            for (size_t i = 0; i < permissions.size(); i++) {
+                if (permissions[i]) locks[lockIndexes[i]] = true;
+            }
+            return locks;
+        }
 
+        /**
+         * Lock the metadata and each lock group required by a set of permissions. Write permissions must imply read
+         * permissions, and bit 0 of writePermissions is set for AddRemove permissions.
+         */
+        inline void AcquireLocks(const std::bitset<1 + sizeof...(AllComponentTypes)> &readPermissions,
+            const std::bitset<1 + sizeof...(AllComponentTypes)> &writePermissions) {
+            writeLocks = GroupLocks(writePermissions);
+            readLocks = GroupLocks(readPermissions) & ~writeLocks;
+            readLocks[0] = !writeLocks[0];
+
+            auto &instance = this->instance;
+            auto &readLocks = this->readLocks;
+            auto &writeLocks = this->writeLocks;
             std::bitset<1 + sizeof...(AllComponentTypes)> acquired;
             // Templated lambda functions for Lock/Unlock so they can be looped over at runtime.
             std::array<std::function<bool(bool)>, acquired.size()> lockFuncs = {
-                [&instance](bool block) {
-                    if (is_add_remove_allowed<LockType>()) {
+                [&](bool block) {
+                    if (writeLocks[0]) {
                         return instance.metadata.WriteLock(block);
                     } else {
                         return instance.metadata.ReadLock(block);
                     }
                 },
-                [&instance](bool block) {
-                    if (is_write_allowed<AllComponentTypes, LockType>()) {
+                [&](bool block) {
+                    constexpr size_t i = 1 + ECSType<AllComponentTypes...>::template GetComponentIndex<
+                                                 AllComponentTypes>();
+                    if (writeLocks[i]) {
                         return instance.template Storage<AllComponentTypes>().WriteLock(block);
-                    } else if (is_read_allowed<AllComponentTypes, LockType>()) {
+                    } else if (readLocks[i]) {
                         return instance.template Storage<AllComponentTypes>().ReadLock(block);
                     }
-                    // This component type isn't part of the lock, skip.
+                    // This component type isn't part of the lock, or shares its group leader's lock, skip.
                     return true;
                 }...};
             std::array<std::function<void()>, acquired.size()> unlockFuncs = {
-                [&instance]() {
-                    if (is_add_remove_allowed<LockType>()) {
-                        return instance.metadata.WriteUnlock();
+                [&]() {
+                    if (writeLocks[0]) {
+                        instance.metadata.WriteUnlock();
                     } else {
-                        return instance.metadata.ReadUnlock();
+                        instance.metadata.ReadUnlock();
                     }
                 },
-                [&instance]() {
-                    if (is_write_allowed<AllComponentTypes, LockType>()) {
+                [&]() {
+                    constexpr size_t i = 1 + ECSType<AllComponentTypes...>::template GetComponentIndex<
+                                                 AllComponentTypes>();
+                    if (writeLocks[i]) {
                         instance.template Storage<AllComponentTypes>().WriteUnlock();
-                    } else if (is_read_allowed<AllComponentTypes, LockType>()) {
+                    } else if (readLocks[i]) {
                         instance.template Storage<AllComponentTypes>().ReadUnlock();
                     }
-                    // This component type isn't part of the lock, skip.
+                    // This component type isn't part of the lock, or shares its group leader's lock, skip.
                 }...};
 
             // Attempt to lock all applicable components and rollback if not all locks can be immediately acquired.
@@ -174,6 +270,128 @@ namespace Tecs {
                 }
             }
 
+            instance.PrepareWriteStorage(writePermissions);
+        }
+
+        /**
+         * Release all component locks that aren't needed to commit, leaving the metadata lock and the write locks in
+         * committedLocks held.
+         */
+        inline void ReleaseUncommittedLocks(const std::bitset<1 + sizeof...(AllComponentTypes)> &committedLocks) {
+            ( // For each AllComponentTypes
+                [&] {
+                    using Leader = typename component_lock_group<AllComponentTypes>::type;
+                    constexpr size_t i = 1 + ECSType<AllComponentTypes...>::template GetComponentIndex<Leader>();
+                    auto &storage = instance.template Storage<AllComponentTypes>();
+                    if (writeLocks[i]) {
+                        if (committedLocks[i]) return;
+                        if constexpr (std::is_same<AllComponentTypes, Leader>()) {
+                            storage.WriteUnlock();
+                        } else {
+                            storage.ClearDirtyIndexes();
+                        }
+                    } else if (readLocks[i] && std::is_same<AllComponentTypes, Leader>()) {
+                        storage.ReadUnlock();
+                    }
+                }(),
+                ...);
+        }
+
+        // Release and reacquire the yielded read locks so that any pending commits on them can complete.
+        inline void YieldReadLocks(const std::bitset<1 + sizeof...(AllComponentTypes)> &yielded) {
+            auto &instance = this->instance;
+            std::array<std::function<bool(bool)>, 1 + sizeof...(AllComponentTypes)> readLockFuncs = {
+                [&instance](bool block) {
+                    return instance.metadata.ReadLock(block);
+                },
+                [&instance](bool block) {
+                    return instance.template Storage<AllComponentTypes>().ReadLock(block);
+                }...};
+            std::array<std::function<void()>, 1 + sizeof...(AllComponentTypes)> readUnlockFuncs = {
+                [&instance]() {
+                    instance.metadata.ReadUnlock();
+                },
+                [&instance]() {
+                    instance.template Storage<AllComponentTypes>().ReadUnlock();
+                }...};
+
+            // Release all read locks so that any pending commits can complete.
+            for (size_t i = 0; i < yielded.size(); i++) {
+                if (yielded[i]) readUnlockFuncs[i]();
+            }
+
+            // Reacquire the read locks, rolling back if not all locks can be immediately acquired.
+            // This should only block while no read locks are held to prevent deadlocks with committing writers.
+            std::bitset<1 + sizeof...(AllComponentTypes)> acquired;
+            bool rollback = false;
+            for (size_t i = 0; acquired != yielded; i = (i + 1) % acquired.size()) {
+                if (!yielded[i]) continue;
+                if (rollback) {
+                    if (acquired[i]) {
+                        readUnlockFuncs[i]();
+                        acquired[i] = false;
+                        continue;
+                    } else if (acquired.none()) {
+                        rollback = false;
+                    }
+                }
+                if (!rollback) {
+                    if (readLockFuncs[i](acquired.none())) {
+                        acquired[i] = true;
+                    } else {
+                        rollback = true;
+                    }
+                }
+            }
+        }
+
+        template<typename T>
+        inline void SetAccessFlag(bool value) {
+            writeAccessedFlags[1 + instance.template GetComponentIndex<T>()] = value;
+        }
+
+        template<typename...>
+        friend class ECS;
+        template<typename, typename...>
+        friend class Lock;
+        friend struct Entity;
+    };
+
+    template<typename... AllComponentTypes, typename... Permissions>
+    class Transaction<ECS<AllComponentTypes...>, Permissions...> : public BaseTransaction<ECS, AllComponentTypes...> {
+    private:
+        using LockType = Lock<ECS<AllComponentTypes...>, Permissions...>;
+        using EntityMetadata = typename ECS<AllComponentTypes...>::EntityMetadata;
+        using FlatPermissions = typename FlattenPermissions<LockType, AllComponentTypes...>::type;
+
+#ifdef TECS_ENABLE_TRACY
+        static inline const auto tracyCtx = []() -> const tracy::SourceLocationData * {
+            static const tracy::SourceLocationData srcloc{"TecsTransaction",
+                FlatPermissions::Name(),
+                __FILE__,
+                __LINE__,
+                0};
+            return &srcloc;
+        };
+    #if defined(TRACY_HAS_CALLSTACK) && defined(TRACY_CALLSTACK)
+        tracy::ScopedZone tracyZone{tracyCtx(), TRACY_CALLSTACK, true};
+    #else
+        tracy::ScopedZone tracyZone{tracyCtx(), true};
+    #endif
+#endif
+
+    public:
+        inline Transaction(ECS<AllComponentTypes...> &instance) : BaseTransaction<ECS, AllComponentTypes...>(instance) {
+#ifdef TECS_ENABLE_PERFORMANCE_TRACING
+            TECS_EXTERNAL_TRACE_TRANSACTION_STARTING(FlatPermissions::Name());
+            instance.transactionTrace.Trace(TraceEvent::Type::TransactionStart);
+#endif
+#ifdef TECS_ENABLE_TRACY
+            ZoneNamedN(tracyScope, "StartTransaction", true);
+#endif
+
+            this->AcquireLocks(ReadPermissions(), WritePermissions());
+
             if (is_add_remove_allowed<LockType>()) {
                 // Init observer event queues
                 std::apply(
@@ -197,36 +415,93 @@ namespace Tecs {
 #endif
             if constexpr (is_add_remove_allowed<LockType>()) {
                 if (this->writeAccessedFlags[0]) {
-                    PreCommitAddRemoveMetadata();
-                    (PreCommitAddRemove<AllComponentTypes>(), ...);
+                    PreCommitAddRemoveMetadata(this->instance);
+                    (PreCommitAddRemove<AllComponentTypes>(this->instance, this->writeAccessedFlags), ...);
                 }
             }
 
-            ( // For each AllComponentTypes, unlock any Noop Writes or Read locks early
+            ( // For each AllComponentTypes, mark deferred writes as unpublished
                 [&] {
-                    if constexpr (is_write_allowed<AllComponentTypes, LockType>()) {
-                        if (!this->instance.template BitsetHas<AllComponentTypes>(this->writeAccessedFlags)) {
-                            this->instance.template Storage<AllComponentTypes>().WriteUnlock();
+                    if constexpr (is_write_deferred<AllComponentTypes, LockType>()) {
+                        // Deferred writes are left in the write buffer for the next writer until they are published.
+                        auto &storage = this->instance.template Storage<AllComponentTypes>();
+                        if (this->instance.template BitsetHas<AllComponentTypes>(this->writeAccessedFlags)) {
+                            storage.unpublished = true;
                         }
-                    } else if constexpr (is_read_allowed<AllComponentTypes, LockType>()) {
-                        this->instance.template Storage<AllComponentTypes>().ReadUnlock();
                     }
                 }(),
                 ...);
+            // Unlock any Noop Writes or Read locks early
+            this->ReleaseUncommittedLocks(this->GroupLocks(this->writeAccessedFlags & CommittedPermissions()));
 
+            this->CommitOrQueue(&Commit);
+
+#ifdef TECS_ENABLE_PERFORMANCE_TRACING
+            TECS_EXTERNAL_TRACE_TRANSACTION_ENDED(FlatPermissions::Name());
+            this->instance.transactionTrace.Trace(TraceEvent::Type::TransactionEnd);
+#endif
+        }
+
+    protected:
+        void Yield() override {
+            if (this->readLocks.none()) return;
+
+            this->YieldReadLocks(this->readLocks);
+        }
+
+    private:
+        inline static const EntityMetadata emptyMetadata = {};
+
+        static inline std::bitset<1 + sizeof...(AllComponentTypes)> ReadPermissions() {
+            std::bitset<1 + sizeof...(AllComponentTypes)> permissions;
+            permissions[0] = true;
+            ((permissions[1 + ECS<AllComponentTypes...>::template GetComponentIndex<AllComponentTypes>()] =
+                     is_read_allowed<AllComponentTypes, LockType>()),
+                ...);
+            return permissions;
+        }
+
+        static inline std::bitset<1 + sizeof...(AllComponentTypes)> WritePermissions() {
+            std::bitset<1 + sizeof...(AllComponentTypes)> permissions;
+            permissions[0] = is_add_remove_allowed<LockType>();
+            ((permissions[1 + ECS<AllComponentTypes...>::template GetComponentIndex<AllComponentTypes>()] =
+                     is_write_allowed<AllComponentTypes, LockType>()),
+                ...);
+            return permissions;
+        }
+
+        // Write permissions that are committed when the transaction ends, excluding deferred writes
+        static inline std::bitset<1 + sizeof...(AllComponentTypes)> CommittedPermissions() {
+            std::bitset<1 + sizeof...(AllComponentTypes)> permissions;
+            permissions[0] = is_add_remove_allowed<LockType>();
+            ((permissions[1 + ECS<AllComponentTypes...>::template GetComponentIndex<AllComponentTypes>()] =
+                     is_write_committed<AllComponentTypes, LockType>()),
+                ...);
+            return permissions;
+        }
+
+        /**
+         * Commits all write-accessed components so they become visible to readers, and releases all remaining locks.
+         *
+         * This may be run on the AsyncCommitThread after the Transaction has been destroyed, so it must only reference
+         * the instance and the provided access flags.
+         */
+        static inline void Commit(ECS<AllComponentTypes...> &instance,
+            const std::bitset<1 + sizeof...(AllComponentTypes)> &writeAccessedFlags) {
+            // Lock groups containing a write-accessed component are committed as a unit by their group leader.
+            auto commitLocks = BaseTransaction<ECS, AllComponentTypes...>::GroupLocks(
+                writeAccessedFlags & CommittedPermissions());
             { // Acquire commit locks for all write-accessed components
 #if defined(TECS_ENABLE_TRACY) && defined(TECS_TRACY_INCLUDE_DETAILED_COMMIT)
                 ZoneNamedN(tracyCommitScope1, "CommitLock", true);
 #endif
                 if constexpr (is_add_remove_allowed<LockType>()) {
-                    if (this->writeAccessedFlags[0]) this->instance.metadata.CommitLock();
+                    if (writeAccessedFlags[0]) instance.metadata.CommitLock();
                 }
                 ( // For each AllComponentTypes
                     [&] {
-                        if constexpr (is_write_allowed<AllComponentTypes, LockType>()) {
-                            if (this->instance.template BitsetHas<AllComponentTypes>(this->writeAccessedFlags)) {
-                                this->instance.template Storage<AllComponentTypes>().CommitLock();
-                            }
+                        if (instance.template BitsetHas<AllComponentTypes>(commitLocks)) {
+                            instance.template Storage<AllComponentTypes>().CommitLock();
                         }
                     }(),
                     ...);
@@ -236,34 +511,68 @@ namespace Tecs {
                 ZoneNamedN(tracyCommitScope2, "Commit", true);
 #endif
                 if constexpr (is_add_remove_allowed<LockType>()) {
-                    if (this->writeAccessedFlags[0]) {
+                    if (writeAccessedFlags[0]) {
+#ifdef TECS_ENABLE_PERFORMANCE_TRACING
+                        instance.metadata.traceInfo.Trace(TraceEvent::Type::ObserverCommitStart);
+                        size_t eventCount = 0;
+                        std::apply(
+                            [&eventCount](auto &...args) {
+                                ((eventCount += args.writeQueue->size()), ...);
+                            },
+                            instance.eventLists);
+#endif
+                        (MoveRemovedComponents<AllComponentTypes>(instance, writeAccessedFlags), ...);
+
                         // Commit observers
                         std::apply(
                             [](auto &...args) {
                                 (args.Commit(), ...);
                             },
-                            this->instance.eventLists);
+                            instance.eventLists);
+#ifdef TECS_ENABLE_PERFORMANCE_TRACING
+                        instance.metadata.traceInfo.Trace(TraceEvent::Type::ObserverCommitEnd, eventCount);
+                        instance.metadata.traceInfo.Trace(TraceEvent::Type::SwapStart);
+#endif
 
-                        this->instance.metadata.readComponents.swap(this->instance.metadata.writeComponents);
-                        this->instance.metadata.readValidEntities.swap(this->instance.metadata.writeValidEntities);
-                        this->instance.globalReadMetadata = this->instance.globalWriteMetadata;
-                        this->instance.metadata.CommitUnlock();
+                        instance.metadata.readComponents.swap(instance.metadata.writeComponents);
+                        instance.metadata.readValidEntities.swap(instance.metadata.writeValidEntities);
+                        instance.metadata.commitCount++;
+                        instance.globalReadMetadata = instance.globalWriteMetadata;
+#ifdef TECS_ENABLE_PERFORMANCE_TRACING
+                        instance.metadata.traceInfo.Trace(TraceEvent::Type::SwapEnd,
+                            instance.metadata.readComponents.size());
+#endif
+                        instance.metadata.CommitUnlock();
                     }
                 }
                 ( // For each AllComponentTypes
                     [&] {
-                        if constexpr (is_write_allowed<AllComponentTypes, LockType>()) {
+                        if constexpr (is_write_committed<AllComponentTypes, LockType>()) {
                             // Skip if no write accesses were made
-                            if (!this->instance.template BitsetHas<AllComponentTypes>(this->writeAccessedFlags)) return;
-                            auto &storage = this->instance.template Storage<AllComponentTypes>();
+                            if (!instance.template BitsetHas<AllComponentTypes>(writeAccessedFlags)) return;
+                            auto &storage = instance.template Storage<AllComponentTypes>();
+#ifdef TECS_ENABLE_PERFORMANCE_TRACING
+                            storage.traceInfo.Trace(TraceEvent::Type::SwapStart);
+#endif
 
-                            storage.readComponents.swap(storage.writeComponents);
+                            storage.CommitSwap();
                             if constexpr (is_add_remove_allowed<LockType>()) {
-                                if (this->writeAccessedFlags[0]) {
+                                if (writeAccessedFlags[0]) {
                                     storage.readValidEntities.swap(storage.writeValidEntities);
                                 }
                             }
-                            storage.CommitUnlock();
+                            // Any previously deferred writes are published along with this commit.
+                            storage.unpublished = false;
+#ifdef TECS_ENABLE_PERFORMANCE_TRACING
+                            storage.traceInfo.Trace(TraceEvent::Type::SwapEnd, storage.readComponents.size());
+#endif
+                        }
+                    }(),
+                    ...);
+                ( // For each AllComponentTypes
+                    [&] {
+                        if (instance.template BitsetHas<AllComponentTypes>(commitLocks)) {
+                            instance.template Storage<AllComponentTypes>().CommitUnlock();
                         }
                     }(),
                     ...);
@@ -271,7 +580,7 @@ namespace Tecs {
 
             ( // For each AllComponentTypes, reset the write storage to match read.
                 [&] {
-                    if constexpr (is_write_allowed<AllComponentTypes, LockType>()) {
+                    if constexpr (is_write_committed<AllComponentTypes, LockType>()) {
 #if defined(TECS_ENABLE_TRACY) && defined(TECS_TRACY_INCLUDE_DETAILED_COMMIT)
                         ZoneNamedN(tracyCommitScope3, "CopyReadComponent", true);
                         ZoneTextV(tracyCommitScope3,
@@ -279,76 +588,166 @@ namespace Tecs {
                             std::strlen(typeid(AllComponentTypes).name()));
 #endif
                         // Skip if no write accesses were made
-                        if (!this->instance.template BitsetHas<AllComponentTypes>(this->writeAccessedFlags)) return;
-                        auto &storage = this->instance.template Storage<AllComponentTypes>();
+                        if (!instance.template BitsetHas<AllComponentTypes>(writeAccessedFlags)) return;
+                        auto &storage = instance.template Storage<AllComponentTypes>();
+#ifdef TECS_ENABLE_PERFORMANCE_TRACING
+                        storage.traceInfo.Trace(TraceEvent::Type::CopyBackStart);
+#endif
 
+                        size_t copies = storage.readComponents.size();
                         if constexpr (is_global_component<AllComponentTypes>()) {
                             storage.writeComponents = storage.readComponents;
-                        } else if (is_add_remove_allowed<LockType>() && this->writeAccessedFlags[0]) {
+                        } else if (is_add_remove_allowed<LockType>() && writeAccessedFlags[0]) {
                             storage.writeComponents = storage.readComponents;
                             storage.writeValidEntities = storage.readValidEntities;
                         } else {
                             // Based on benchmarks, it is faster to bulk copy if more than
                             // roughly 1/6 of the components are valid.
+                            // The recycled history buffer may predate entities added since it was last used, and
+                            // the write buffer is left empty if the read buffer was shared with a fork.
+                            if (storage.writeComponents.size() < storage.readComponents.size()) {
+                                storage.writeComponents.resize(storage.readComponents.size());
+                            }
                             if (storage.readValidEntities.size() > storage.readComponents.size() / 6) {
                                 storage.writeComponents = storage.readComponents;
                             } else {
                                 for (auto &valid : storage.readValidEntities) {
                                     storage.writeComponents[valid.index] = storage.readComponents[valid.index];
                                 }
+                                copies = storage.readValidEntities.size();
                             }
                         }
-                        storage.WriteUnlock();
+                        if constexpr (is_change_tracked<AllComponentTypes>()) {
+                            storage.writeChangeTicks = storage.readChangeTicks;
+                        }
+                        if constexpr (is_global_component<AllComponentTypes>()) {
+                            auto &globalMetadata = instance.globalReadMetadata;
+                            bool hasGlobal = instance.template BitsetHas<AllComponentTypes>(globalMetadata);
+                            storage.stats.validEntityCount.store(hasGlobal ? 1 : 0, std::memory_order_relaxed);
+                        } else {
+                            storage.stats.validEntityCount.store(storage.readValidEntities.size(),
+                                std::memory_order_relaxed);
+                        }
+                        storage.stats.lastCommitCopies.store(copies, std::memory_order_relaxed);
+#ifdef TECS_ENABLE_PERFORMANCE_TRACING
+                        storage.traceInfo.Trace(TraceEvent::Type::CopyBackEnd, copies);
+#endif
+                    }
+                }(),
+                ...);
+            ( // For each AllComponentTypes, release the write lock of each committed lock group
+                [&] {
+                    using Leader = typename component_lock_group<AllComponentTypes>::type;
+                    if (!instance.template BitsetHas<Leader>(commitLocks)) return;
+                    if constexpr (std::is_same<AllComponentTypes, Leader>()) {
+                        instance.template Storage<AllComponentTypes>().WriteUnlock();
+                    } else {
+                        instance.template Storage<AllComponentTypes>().ClearDirtyIndexes();
                     }
                 }(),
                 ...);
             if constexpr (is_add_remove_allowed<LockType>()) {
-                if (this->writeAccessedFlags[0]) {
-                    this->instance.metadata.writeComponents = this->instance.metadata.readComponents;
-                    this->instance.metadata.writeValidEntities = this->instance.metadata.readValidEntities;
+                if (writeAccessedFlags[0]) {
+#ifdef TECS_ENABLE_PERFORMANCE_TRACING
+                    instance.metadata.traceInfo.Trace(TraceEvent::Type::CopyBackStart);
+#endif
+                    instance.metadata.writeComponents = instance.metadata.readComponents;
+                    instance.metadata.writeValidEntities = instance.metadata.readValidEntities;
+                    instance.metadata.stats.validEntityCount.store(instance.metadata.readValidEntities.size(),
+                        std::memory_order_relaxed);
+                    instance.metadata.stats.lastCommitCopies.store(instance.metadata.readComponents.size(),
+                        std::memory_order_relaxed);
+#ifdef TECS_ENABLE_PERFORMANCE_TRACING
+                    instance.metadata.traceInfo.Trace(TraceEvent::Type::CopyBackEnd,
+                        instance.metadata.readComponents.size());
+#endif
                 }
             }
             if constexpr (is_add_remove_allowed<LockType>()) {
-                this->instance.metadata.WriteUnlock();
+                instance.metadata.WriteUnlock();
             } else {
-                this->instance.metadata.ReadUnlock();
+                instance.metadata.ReadUnlock();
             }
+        }
 
-#ifdef TECS_ENABLE_PERFORMANCE_TRACING
-            TECS_EXTERNAL_TRACE_TRANSACTION_ENDED(FlatPermissions::Name());
-            this->instance.transactionTrace.Trace(TraceEvent::Type::TransactionEnd);
-#endif
+        template<typename U>
+        static inline void EmplaceRemovedEvent(ECS<AllComponentTypes...> &instance,
+            const std::bitset<1 + sizeof...(AllComponentTypes)> &writeAccessedFlags,
+            const Entity &entity,
+            size_t index) {
+            auto &observerList = instance.template Observers<ComponentEvent<U>>();
+            if (instance.template BitsetHas<U>(writeAccessedFlags)) {
+                // The removed value will be moved into this event by MoveRemovedComponents() once readers are locked.
+                observerList.writeQueue->emplace_back(EventType::REMOVED, entity, U());
+            } else {
+                observerList.writeQueue->emplace_back(EventType::REMOVED,
+                    entity,
+                    instance.template Storage<U>().readComponents[index]);
+            }
         }
 
-    private:
-        inline static const EntityMetadata emptyMetadata = {};
+        /**
+         * Moves removed component values out of the read buffer and into their REMOVED events.
+         *
+         * This must only be called while the commit lock is held for this component type, since readers may still be
+         * referencing the read buffer before then. The moved-from read buffer becomes the write buffer after the swap,
+         * and is fully overwritten when the write buffer is reset to match the new read buffer.
+         *
+         * Components with history keep the replaced read buffer in the history ring instead, and read buffers shared
+         * with a fork must not be modified, so their removed values are copied.
+         */
+        template<typename U>
+        static inline void MoveRemovedComponents(ECS<AllComponentTypes...> &instance,
+            const std::bitset<1 + sizeof...(AllComponentTypes)> &writeAccessedFlags) {
+            if (!instance.template BitsetHas<U>(writeAccessedFlags)) return;
+            auto &observerList = instance.template Observers<ComponentEvent<U>>();
+            if (observerList.observers.empty()) return;
+
+            auto &storage = instance.template Storage<U>();
+            bool copy = component_history_depth<U>::value > 0 || storage.readComponents.IsShared();
+            for (auto &event : *observerList.writeQueue) {
+                if (event.type == EventType::REMOVED) {
+                    // Global component events have an invalid entity with index 0
+                    if (copy) {
+                        event.component = storage.readComponents[event.entity.index];
+                    } else {
+                        event.component = std::move(storage.readComponents[event.entity.index]);
+                    }
+                }
+            }
+        }
 
-        inline void PreCommitAddRemoveMetadata() const {
+        static inline void PreCommitAddRemoveMetadata(ECS<AllComponentTypes...> &instance) {
+#ifdef TECS_ENABLE_PERFORMANCE_TRACING
+            instance.metadata.traceInfo.Trace(TraceEvent::Type::PreCommitStart);
+#endif
             // Rebuild writeValidEntities, validEntityIndexes, and freeEntities with the new entity set.
-            this->instance.metadata.writeValidEntities.clear();
-            this->instance.freeEntities.clear();
+            instance.metadata.writeValidEntities.clear();
+            instance.freeEntities.clear();
+            instance.takenFreeEntities.clear();
 
-            const auto &writeMetadataList = this->instance.metadata.writeComponents;
+            const auto &writeMetadataList = instance.metadata.writeComponents;
             for (TECS_ENTITY_INDEX_TYPE index = 0; index < writeMetadataList.size(); index++) {
                 const auto &newMetadata = writeMetadataList[index];
-                const auto &oldMetadata = index >= this->instance.metadata.readComponents.size()
+                const auto &oldMetadata = index >= instance.metadata.readComponents.size()
                                               ? emptyMetadata
-                                              : this->instance.metadata.readComponents[index];
+                                              : instance.metadata.readComponents[index];
 
                 // If this index exists, add it to the valid entity lists.
                 if (newMetadata[0]) {
-                    this->instance.metadata.validEntityIndexes[index] =
-                        this->instance.metadata.writeValidEntities.size();
-                    this->instance.metadata.writeValidEntities.emplace_back(index, newMetadata.generation);
+                    instance.metadata.validEntityIndexes[index] =
+                        instance.metadata.writeValidEntities.size();
+                    instance.metadata.writeValidEntities.emplace_back(index, newMetadata.generation);
                 } else {
-                    this->instance.freeEntities.emplace_back(index,
+                    instance.freeEntities.emplace_back(index,
                         newMetadata.generation + 1,
-                        (TECS_ENTITY_ECS_IDENTIFIER_TYPE)this->instance.ecsId);
+                        (TECS_ENTITY_ECS_IDENTIFIER_TYPE)instance.ecsId);
                 }
 
                 // Compare new and old metadata to notify observers
                 if (newMetadata[0] != oldMetadata[0] || newMetadata.generation != oldMetadata.generation) {
-                    auto &observerList = this->instance.template Observers<EntityEvent>();
+                    auto &observerList = instance.template Observers<EntityEvent>();
+                    if (observerList.observers.empty()) continue;
                     if (oldMetadata[0]) {
                         observerList.writeQueue->emplace_back(EventType::REMOVED,
                             Entity(index, oldMetadata.generation));
@@ -358,55 +757,61 @@ namespace Tecs {
                     }
                 }
             }
+#ifdef TECS_ENABLE_PERFORMANCE_TRACING
+            instance.metadata.traceInfo.Trace(TraceEvent::Type::PreCommitEnd, writeMetadataList.size());
+#endif
         }
 
         template<typename U>
-        inline void PreCommitAddRemove() const {
+        static inline void PreCommitAddRemove(ECS<AllComponentTypes...> &instance,
+            const std::bitset<1 + sizeof...(AllComponentTypes)> &writeAccessedFlags) {
+            auto &observerList = instance.template Observers<ComponentEvent<U>>();
             if constexpr (is_global_component<U>()) {
-                const auto &oldMetadata = this->instance.globalReadMetadata;
-                const auto &newMetadata = this->instance.globalWriteMetadata;
-                if (this->instance.template BitsetHas<U>(newMetadata)) {
-                    if (!this->instance.template BitsetHas<U>(oldMetadata)) {
-                        auto &observerList = this->instance.template Observers<ComponentEvent<U>>();
+                const auto &oldMetadata = instance.globalReadMetadata;
+                const auto &newMetadata = instance.globalWriteMetadata;
+                if (observerList.observers.empty()) return;
+                if (instance.template BitsetHas<U>(newMetadata)) {
+                    if (!instance.template BitsetHas<U>(oldMetadata)) {
                         observerList.writeQueue->emplace_back(EventType::ADDED,
                             Entity(),
-                            this->instance.template Storage<U>().writeComponents[0]);
+                            instance.template Storage<U>().writeComponents[0]);
                     }
-                } else if (this->instance.template BitsetHas<U>(oldMetadata)) {
-                    auto &observerList = this->instance.template Observers<ComponentEvent<U>>();
-                    observerList.writeQueue->emplace_back(EventType::REMOVED,
-                        Entity(),
-                        this->instance.template Storage<U>().readComponents[0]);
+                } else if (instance.template BitsetHas<U>(oldMetadata)) {
+                    EmplaceRemovedEvent<U>(instance, writeAccessedFlags, Entity(), 0);
                 }
             } else {
-                auto &storage = this->instance.template Storage<U>();
+                auto &storage = instance.template Storage<U>();
+#ifdef TECS_ENABLE_PERFORMANCE_TRACING
+                storage.traceInfo.Trace(TraceEvent::Type::PreCommitStart);
+#endif
 
                 // Rebuild writeValidEntities and validEntityIndexes with the new entity set.
                 storage.writeValidEntities.clear();
 
-                const auto &writeMetadataList = this->instance.metadata.writeComponents;
+                const auto &writeMetadataList = instance.metadata.writeComponents;
                 for (TECS_ENTITY_INDEX_TYPE index = 0; index < writeMetadataList.size(); index++) {
                     const auto &newMetadata = writeMetadataList[index];
-                    const auto &oldMetadata = index >= this->instance.metadata.readComponents.size()
+                    const auto &oldMetadata = index >= instance.metadata.readComponents.size()
                                                   ? emptyMetadata
-                                                  : this->instance.metadata.readComponents[index];
+                                                  : instance.metadata.readComponents[index];
 
                     // If this index exists, add it to the valid entity lists.
-                    if (newMetadata[0] && this->instance.template BitsetHas<U>(newMetadata)) {
+                    if (newMetadata[0] && instance.template BitsetHas<U>(newMetadata)) {
 
                         storage.validEntityIndexes[index] = storage.writeValidEntities.size();
                         storage.writeValidEntities.emplace_back(index, newMetadata.generation);
                     }
 
                     // Compare new and old metadata to notify observers
-                    bool newExists = this->instance.template BitsetHas<U>(newMetadata);
-                    bool oldExists = this->instance.template BitsetHas<U>(oldMetadata);
+                    if (observerList.observers.empty()) continue;
+                    bool newExists = instance.template BitsetHas<U>(newMetadata);
+                    bool oldExists = instance.template BitsetHas<U>(oldMetadata);
                     if (newExists != oldExists || newMetadata.generation != oldMetadata.generation) {
-                        auto &observerList = this->instance.template Observers<ComponentEvent<U>>();
                         if (oldExists) {
-                            observerList.writeQueue->emplace_back(EventType::REMOVED,
+                            EmplaceRemovedEvent<U>(instance,
+                                writeAccessedFlags,
                                 Entity(index, oldMetadata.generation),
-                                storage.readComponents[index]);
+                                index);
                         }
                         if (newExists) {
                             observerList.writeQueue->emplace_back(EventType::ADDED,
@@ -415,7 +820,116 @@ namespace Tecs {
                         }
                     }
                 }
+#ifdef TECS_ENABLE_PERFORMANCE_TRACING
+                storage.traceInfo.Trace(TraceEvent::Type::PreCommitEnd, writeMetadataList.size());
+#endif
+            }
+        }
+
+        template<template<typename...> typename, typename...>
+        friend class DynamicTransaction;
+    };
+
+    /**
+     * A DynamicTransaction locks a set of components chosen at runtime, for systems such as script runtimes that don't
+     * know which components they will access at compile time. It is started by ecs.StartTransaction(read, write), and
+     * its permissions are accessed through the returned DynamicLock.
+     *
+     * Only the requested components are locked, so dynamic transactions can run in parallel with any static
+     * transactions that don't conflict with them. Commits are run by the equivalent static Transaction type.
+     */
+    template<template<typename...> typename ECSType, typename... AllComponentTypes>
+    class DynamicTransaction : public BaseTransaction<ECSType, AllComponentTypes...> {
+    private:
+        using ECS = ECSType<AllComponentTypes...>;
+        using PermissionBitset = std::bitset<1 + sizeof...(AllComponentTypes)>;
+        using AddRemoveTransaction = Transaction<ECS, AddRemove>;
+        using WriteTransaction = Transaction<ECS, WriteAll>;
+
+#ifdef TECS_ENABLE_TRACY
+        static inline const auto tracyCtx = []() -> const tracy::SourceLocationData * {
+            static const tracy::SourceLocationData srcloc{"TecsTransaction",
+                "DynamicTransaction",
+                __FILE__,
+                __LINE__,
+                0};
+            return &srcloc;
+        };
+    #if defined(TRACY_HAS_CALLSTACK) && defined(TRACY_CALLSTACK)
+        tracy::ScopedZone tracyZone{tracyCtx(), TRACY_CALLSTACK, true};
+    #else
+        tracy::ScopedZone tracyZone{tracyCtx(), true};
+    #endif
+#endif
+
+    public:
+        /**
+         * readPermissions and writePermissions must already be normalized by the caller: bit 0 of readPermissions is
+         * always set, write access implies read access, and AddRemove (bit 0 of writePermissions) implies write access
+         * to all components.
+         */
+        inline DynamicTransaction(ECS &instance, const PermissionBitset &readPermissions,
+            const PermissionBitset &writePermissions)
+            : BaseTransaction<ECSType, AllComponentTypes...>(instance), readPermissions(readPermissions),
+              writePermissions(writePermissions) {
+#ifdef TECS_ENABLE_PERFORMANCE_TRACING
+            TECS_EXTERNAL_TRACE_TRANSACTION_STARTING("DynamicTransaction");
+            instance.transactionTrace.Trace(TraceEvent::Type::TransactionStart);
+#endif
+#ifdef TECS_ENABLE_TRACY
+            ZoneNamedN(tracyScope, "StartTransaction", true);
+#endif
+
+            this->AcquireLocks(readPermissions, writePermissions);
+
+            if (writePermissions[0]) {
+                // Init observer event queues
+                std::apply(
+                    [](auto &...args) {
+                        (args.Init(), ...);
+                    },
+                    this->instance.eventLists);
+            }
+
+#ifdef TECS_ENABLE_PERFORMANCE_TRACING
+            TECS_EXTERNAL_TRACE_TRANSACTION_STARTED("DynamicTransaction");
+#endif
+        }
+
+        inline ~DynamicTransaction() {
+#ifdef TECS_ENABLE_PERFORMANCE_TRACING
+            TECS_EXTERNAL_TRACE_TRANSACTION_ENDING("DynamicTransaction");
+#endif
+#ifdef TECS_ENABLE_TRACY
+            ZoneNamedN(tracyTxScope, "EndTransaction", true);
+#endif
+            if (writePermissions[0] && this->writeAccessedFlags[0]) {
+                AddRemoveTransaction::PreCommitAddRemoveMetadata(this->instance);
+                (AddRemoveTransaction::template PreCommitAddRemove<AllComponentTypes>(this->instance,
+                     this->writeAccessedFlags),
+                    ...);
             }
+
+            // Unlock any Noop Writes or Read locks early
+            this->ReleaseUncommittedLocks(this->GroupLocks(this->writeAccessedFlags & writePermissions));
+
+            this->CommitOrQueue(writePermissions[0] ? &AddRemoveTransaction::Commit : &WriteTransaction::Commit);
+
+#ifdef TECS_ENABLE_PERFORMANCE_TRACING
+            TECS_EXTERNAL_TRACE_TRANSACTION_ENDED("DynamicTransaction");
+            this->instance.transactionTrace.Trace(TraceEvent::Type::TransactionEnd);
+#endif
         }
+
+    protected:
+        void Yield() override {
+            if (this->readLocks.none()) return;
+
+            this->YieldReadLocks(this->readLocks);
+        }
+
+    private:
+        const PermissionBitset readPermissions;
+        const PermissionBitset writePermissions;
     };
 }; // namespace Tecs
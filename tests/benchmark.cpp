@@ -7,6 +7,7 @@
 #include <fstream>
 #include <future>
 #include <iomanip>
+#include <memory_resource>
 #include <thread>
 
 #ifdef _WIN32
@@ -43,7 +44,6 @@ void renderThread() {
     MultiTimer timer1("RenderThread StartTransaction");
     MultiTimer timer2("RenderThread Run");
     MultiTimer timer3("RenderThread Unlock");
-    std::vector<std::string> bad;
     double currentTransformValue = 0;
     uint32_t currentScriptValue = 0;
     size_t readCount = 0;
@@ -56,6 +56,7 @@ void renderThread() {
             auto readLock = ecs.StartTransaction<Read<Renderable, Transform, Script>>();
             t = timer2;
 
+            std::pmr::vector<std::pmr::string> bad(&readLock.Scratch());
             auto &validRenderables = readLock.EntitiesWith<Renderable>();
             auto &validTransforms = readLock.EntitiesWith<Transform>();
             auto &validEntities = validRenderables.size() > validTransforms.size() ? validTransforms : validRenderables;
@@ -78,6 +79,7 @@ void renderThread() {
                 }
             }
             currentScriptValue = firstScriptEntity.Get<Script>(readLock).data[0];
+            badCount += bad.size();
 
             t = timer3;
         }
@@ -85,8 +87,6 @@ void renderThread() {
         FrameMark;
 #endif
         readCount++;
-        badCount += bad.size();
-        bad.clear();
         lastFrameEnd += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::seconds(1)) / 90;
         std::this_thread::sleep_until(lastFrameEnd);
     }
@@ -108,7 +108,7 @@ void renderThread() {
 
 void scriptWorkerThread(MultiTimer *workerTimer, Lock<testing::ECS, Write<Script>> lock, EntityView entities) {
     Timer t(*workerTimer);
-    for (auto &e : entities) {
+    for (auto &e : entities.span()) {
         auto &script = e.Get<Script>(lock);
         // "Run" script
         for (uint32_t &data : script.data) {
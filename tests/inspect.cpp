@@ -0,0 +1,29 @@
+#include <Tecs_inspector.hh>
+#include <exception>
+#include <iostream>
+#include <string>
+
+/**
+ * Prints a stats snapshot from a running program that is serving a Tecs::Inspector on a Unix domain socket.
+ *
+ * Usage: Tecs-inspect <socket_path> [json|text]
+ */
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <socket_path> [json|text]" << std::endl;
+        return 1;
+    }
+    std::string format = argc > 2 ? argv[2] : "text";
+    if (format != "json" && format != "text") {
+        std::cerr << "Unknown format: " << format << std::endl;
+        return 1;
+    }
+
+    try {
+        std::cout << Tecs::Inspector::Query(argv[1], format);
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,410 @@
+#include "utils.hh"
+
+#include <Tecs.hh>
+#include <bitset>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace testing;
+
+/**
+ * Replays the transaction pattern recorded in a PerformanceTrace CSV (as written by PerformanceTrace::SaveToCSV)
+ * against a synthetic ECS, so that locking and commit changes can be compared against a real workload offline.
+ *
+ * For every transaction in the trace, the thread, start time, permissions, hold time, and which components were
+ * committed are reconstructed from the lock events. Each recorded thread is then replayed on its own thread with the
+ * same start offsets and hold times, and the resulting lock waits and commit times are reported.
+ *
+ * Usage: Tecs-replay <trace.csv> [entity_count] [component_density] [time_scale]
+ *
+ * The synthetic component size and count can be changed at compile time by defining
+ * REPLAY_COMPONENT_SIZE and REPLAY_COMPONENT_COUNT. Transactions are started from runtime permission bitsets, so
+ * the build cost only grows linearly with the component count.
+ */
+
+#ifndef REPLAY_COMPONENT_COUNT
+    #define REPLAY_COMPONENT_COUNT 4
+#endif
+#ifndef REPLAY_COMPONENT_SIZE
+    #define REPLAY_COMPONENT_SIZE 64
+#endif
+
+#define DEFAULT_ENTITY_COUNT 100000
+#define DEFAULT_COMPONENT_DENSITY 0.5
+#define DEFAULT_TIME_SCALE 1.0
+
+namespace replay {
+    template<size_t I>
+    struct Payload {
+        uint8_t data[REPLAY_COMPONENT_SIZE];
+    };
+
+    template<size_t... I>
+    Tecs::ECS<Payload<I>...> MakeECS(std::index_sequence<I...>);
+    using ECS = decltype(MakeECS(std::make_index_sequence<REPLAY_COMPONENT_COUNT>()));
+
+    using ComponentBitset = std::bitset<REPLAY_COMPONENT_COUNT>;
+    using ECSBitset = std::bitset<1 + REPLAY_COMPONENT_COUNT>;
+
+    struct TraceRow {
+        std::string event;
+        std::string thread;
+        int64_t timeNs;
+    };
+
+    struct TraceStream {
+        std::string name;
+        std::vector<TraceRow> rows;
+    };
+
+    struct ReplayTransaction {
+        std::string thread;
+        int64_t startNs = 0;
+        int64_t endNs = -1;
+        int64_t lockedNs = -1;
+        int64_t releaseNs = -1;
+
+        bool addRemove = false;
+        bool addRemoveCommit = false;
+        ComponentBitset read;
+        ComponentBitset write;
+        ComponentBitset commit;
+    };
+
+    static ECS ecs;
+
+    std::vector<std::string> SplitCSVLine(const std::string &line) {
+        std::vector<std::string> fields;
+        std::stringstream ss(line);
+        std::string field;
+        while (std::getline(ss, field, ',')) {
+            fields.emplace_back(field);
+        }
+        if (!line.empty() && line.back() == ',') fields.emplace_back();
+        return fields;
+    }
+
+    std::vector<TraceStream> LoadTrace(std::istream &in) {
+        std::string line;
+        if (!std::getline(in, line)) throw std::runtime_error("Trace file is empty");
+
+        auto header = SplitCSVLine(line);
+        // Older traces don't have a Value column for each stream
+        size_t columns = header.size() >= 4 && header[3] == "Transaction Value" ? 4 : 3;
+        if (header.size() < columns * 2 || header.size() % columns != 0) {
+            throw std::runtime_error("Trace file has an invalid header");
+        }
+        std::vector<TraceStream> streams(header.size() / columns);
+        for (size_t i = 0; i < streams.size(); i++) {
+            auto &name = header[i * columns];
+            streams[i].name = name.substr(0, name.rfind(" Event"));
+        }
+
+        while (std::getline(in, line)) {
+            auto fields = SplitCSVLine(line);
+            for (size_t i = 0; i < streams.size() && i * columns + 2 < fields.size(); i++) {
+                size_t first = i * columns;
+                if (fields[first].empty()) continue;
+                streams[i].rows.push_back(TraceRow{fields[first], fields[first + 1], std::stoll(fields[first + 2])});
+            }
+        }
+        return streams;
+    }
+
+    std::map<std::string, std::vector<ReplayTransaction>> BuildTransactions(const std::vector<TraceStream> &streams) {
+        if (streams.size() - 2 > REPLAY_COMPONENT_COUNT) {
+            throw std::runtime_error("Trace contains " + std::to_string(streams.size() - 2) +
+                                     " component types, rebuild with REPLAY_COMPONENT_COUNT=" +
+                                     std::to_string(streams.size() - 2));
+        }
+
+        std::map<std::string, std::vector<ReplayTransaction>> threads;
+        std::map<std::string, std::deque<size_t>> openTransactions;
+        for (auto &row : streams[0].rows) {
+            auto &transactions = threads[row.thread];
+            if (row.event == "TransactionStart") {
+                openTransactions[row.thread].push_back(transactions.size());
+                auto &transaction = transactions.emplace_back();
+                transaction.thread = row.thread;
+                transaction.startNs = row.timeNs;
+            } else if (row.event == "TransactionEnd") {
+                auto &open = openTransactions[row.thread];
+                if (open.empty()) continue;
+                transactions[open.front()].endNs = row.timeNs;
+                open.pop_front();
+            }
+        }
+        // Drop any transactions that were still running when the trace was stopped
+        for (auto &[name, transactions] : threads) {
+            transactions.erase(std::remove_if(transactions.begin(),
+                                   transactions.end(),
+                                   [](auto &transaction) {
+                                       return transaction.endNs < 0;
+                                   }),
+                transactions.end());
+        }
+
+        auto findTransaction = [&threads](const TraceRow &row) -> ReplayTransaction * {
+            auto it = threads.find(row.thread);
+            if (it == threads.end()) return nullptr;
+            auto &transactions = it->second;
+            auto next = std::upper_bound(transactions.begin(),
+                transactions.end(),
+                row.timeNs,
+                [](int64_t timeNs, auto &transaction) {
+                    return timeNs < transaction.startNs;
+                });
+            if (next == transactions.begin()) return nullptr;
+            auto &transaction = *(next - 1);
+            if (row.timeNs > transaction.endNs) return nullptr;
+            return &transaction;
+        };
+
+        // The last acquired lock marks the start of the transaction body. Locks may be acquired and released multiple
+        // times while the transaction is starting, so this must be found before looking for the first release.
+        for (size_t i = 1; i < streams.size(); i++) {
+            for (auto &row : streams[i].rows) {
+                auto *transaction = findTransaction(row);
+                if (!transaction) continue;
+                if (row.event == "ReadLock" || row.event == "WriteLock") {
+                    transaction->lockedNs = std::max(transaction->lockedNs, row.timeNs);
+                }
+            }
+        }
+        for (size_t i = 1; i < streams.size(); i++) {
+            for (auto &row : streams[i].rows) {
+                auto *transaction = findTransaction(row);
+                if (!transaction) continue;
+                bool isMetadata = i == 1;
+                if (row.event == "ReadLock") {
+                    if (!isMetadata) transaction->read[i - 2] = true;
+                } else if (row.event == "WriteLock") {
+                    if (isMetadata) {
+                        transaction->addRemove = true;
+                    } else {
+                        transaction->write[i - 2] = true;
+                    }
+                } else if (row.event == "CommitLockWait" || row.event == "CommitLock") {
+                    if (isMetadata) {
+                        transaction->addRemoveCommit = true;
+                    } else {
+                        transaction->commit[i - 2] = true;
+                    }
+                }
+                if (row.timeNs >= transaction->lockedNs && (row.event == "ReadUnlock" || row.event == "WriteUnlock" ||
+                                                               row.event == "PreCommitStart" ||
+                                                               row.event == "CommitLockWait" ||
+                                                               row.event == "CommitLock")) {
+                    if (transaction->releaseNs < 0 || row.timeNs < transaction->releaseNs) {
+                        transaction->releaseNs = row.timeNs;
+                    }
+                }
+            }
+        }
+        for (auto &[name, transactions] : threads) {
+            for (auto &transaction : transactions) {
+                if (transaction.lockedNs < 0) transaction.lockedNs = transaction.startNs;
+                if (transaction.releaseNs < 0) transaction.releaseNs = transaction.endNs;
+            }
+        }
+        return threads;
+    }
+
+    // Returns the runtime permission bitsets for ecs.StartTransaction() matching a recorded transaction
+    std::pair<ECSBitset, ECSBitset> TransactionPermissions(const ReplayTransaction &transaction) {
+        ECSBitset read, write;
+        write[0] = transaction.addRemove;
+        for (size_t i = 0; i < REPLAY_COMPONENT_COUNT; i++) {
+            read[1 + i] = transaction.read[i];
+            write[1 + i] = transaction.write[i];
+        }
+        return {read, write};
+    }
+
+    template<size_t... I>
+    void TouchCommittedComponents(const Tecs::DynamicLock<ECS> &lock,
+        const ReplayTransaction &transaction,
+        std::index_sequence<I...>) {
+        ( // For each replay component, make a write so the transaction commits it
+            [&] {
+                if (!transaction.commit[I]) return;
+                auto writeLock = lock.TryLock<Tecs::Write<Payload<I>>>();
+                if (!writeLock) return;
+                auto &entities = writeLock->template EntitiesWith<Payload<I>>();
+                if (!entities.empty()) entities[0].template Get<Payload<I>>(*writeLock).data[0]++;
+            }(),
+            ...);
+        if (transaction.addRemoveCommit) {
+            auto addRemoveLock = lock.TryLock<Tecs::AddRemove>();
+            if (addRemoveLock) addRemoveLock->NewEntity().Destroy(*addRemoveLock);
+        }
+    }
+
+    struct ThreadStats {
+        std::string name;
+        MultiTimer recordedWait;
+        MultiTimer replayWait;
+        MultiTimer recordedCommit;
+        MultiTimer replayCommit;
+        size_t lateStarts = 0;
+
+        ThreadStats(const std::string &name)
+            : name(name), recordedWait(name + " Recorded StartTransaction"),
+              replayWait(name + " Replay StartTransaction"), recordedCommit(name + " Recorded Commit"),
+              replayCommit(name + " Replay Commit") {}
+    };
+
+    void ReplayThread(const std::vector<ReplayTransaction> &transactions,
+        ThreadStats &stats,
+        std::chrono::steady_clock::time_point replayStart,
+        int64_t traceStartNs,
+        double timeScale) {
+        auto scaled = [timeScale](int64_t ns) {
+            return std::chrono::nanoseconds((int64_t)((double)ns * timeScale));
+        };
+
+        for (auto &transaction : transactions) {
+            auto target = replayStart + scaled(transaction.startNs - traceStartNs);
+            if (std::chrono::steady_clock::now() > target) {
+                stats.lateStarts++;
+            } else {
+                std::this_thread::sleep_until(target);
+            }
+
+            auto [readPermissions, writePermissions] = TransactionPermissions(transaction);
+            auto start = std::chrono::steady_clock::now();
+            std::chrono::steady_clock::time_point commitStart;
+            {
+                auto lock = ecs.StartTransaction(readPermissions, writePermissions);
+                auto locked = std::chrono::steady_clock::now();
+                stats.replayWait.AddValue(locked - start);
+
+                TouchCommittedComponents(lock, transaction, std::make_index_sequence<REPLAY_COMPONENT_COUNT>());
+
+                // Simulate the recorded work by holding the locks for the same duration
+                auto release = locked + scaled(transaction.releaseNs - transaction.lockedNs);
+                while (std::chrono::steady_clock::now() < release) {
+                    std::this_thread::yield();
+                }
+                commitStart = std::chrono::steady_clock::now();
+            }
+            stats.replayCommit.AddValue(std::chrono::steady_clock::now() - commitStart);
+
+            stats.recordedWait.AddValue(scaled(transaction.lockedNs - transaction.startNs));
+            stats.recordedCommit.AddValue(scaled(transaction.endNs - transaction.releaseNs));
+        }
+    }
+
+    template<size_t... I>
+    void PopulateECS(size_t entityCount, double density, std::index_sequence<I...>) {
+        std::mt19937 rand(entityCount);
+        std::bernoulli_distribution hasComponent(density);
+
+        auto lock = ecs.StartTransaction<Tecs::AddRemove>();
+        for (size_t i = 0; i < entityCount; i++) {
+            auto e = lock.NewEntity();
+            ( // For each replay component
+                [&] {
+                    if (hasComponent(rand)) e.Set<Payload<I>>(lock);
+                }(),
+                ...);
+        }
+    }
+} // namespace replay
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <trace.csv> [entity_count] [component_density] [time_scale]"
+                  << std::endl;
+        return 1;
+    }
+    size_t entityCount = argc > 2 ? std::stoull(argv[2]) : DEFAULT_ENTITY_COUNT;
+    double density = argc > 3 ? std::stod(argv[3]) : DEFAULT_COMPONENT_DENSITY;
+    double timeScale = argc > 4 ? std::stod(argv[4]) : DEFAULT_TIME_SCALE;
+
+    std::ifstream file(argv[1]);
+    if (!file) {
+        std::cerr << "Failed to open trace file: " << argv[1] << std::endl;
+        return 1;
+    }
+    auto threads = replay::BuildTransactions(replay::LoadTrace(file));
+
+    int64_t traceStartNs = INT64_MAX;
+    int64_t traceEndNs = INT64_MIN;
+    size_t transactionCount = 0;
+    for (auto &[name, transactions] : threads) {
+        for (auto &transaction : transactions) {
+            traceStartNs = std::min(traceStartNs, transaction.startNs);
+            traceEndNs = std::max(traceEndNs, transaction.endNs);
+        }
+        transactionCount += transactions.size();
+    }
+    if (transactionCount == 0) {
+        std::cerr << "Trace contains no complete transactions" << std::endl;
+        return 1;
+    }
+
+    {
+        Timer t("Create " + std::to_string(entityCount) + " entities with " + std::to_string(REPLAY_COMPONENT_SIZE) +
+                " byte components");
+        replay::PopulateECS(entityCount, density, std::make_index_sequence<REPLAY_COMPONENT_COUNT>());
+    }
+
+    std::cout << "Replaying " << transactionCount << " transactions from " << threads.size() << " threads over "
+              << ((double)(traceEndNs - traceStartNs) * timeScale / 1000000.0) << " ms" << std::endl;
+
+    std::deque<replay::ThreadStats> stats;
+    {
+        Timer t("Replay trace");
+
+#ifdef TECS_ENABLE_PERFORMANCE_TRACING
+        replay::ecs.StartTrace();
+#endif
+
+        std::vector<std::future<void>> workers;
+        std::vector<std::thread::id> workerIds(threads.size());
+        auto replayStart = std::chrono::steady_clock::now() + std::chrono::milliseconds(10);
+        size_t i = 0;
+        for (auto &[name, transactions] : threads) {
+            auto &threadStats = stats.emplace_back(name);
+            auto &threadId = workerIds[i++];
+            workers.emplace_back(std::async(std::launch::async, [&, replayStart] {
+                threadId = std::this_thread::get_id();
+                replay::ReplayThread(transactions, threadStats, replayStart, traceStartNs, timeScale);
+            }));
+        }
+        for (auto &worker : workers) {
+            worker.get();
+        }
+
+#ifdef TECS_ENABLE_PERFORMANCE_TRACING
+        auto trace = replay::ecs.StopTrace();
+        i = 0;
+        for (auto &[name, transactions] : threads) {
+            trace.SetThreadName(name, workerIds[i++]);
+        }
+        std::ofstream traceFile("replay-trace.csv");
+        trace.SaveToCSV(traceFile);
+        std::cout << "Replay trace saved to replay-trace.csv" << std::endl;
+#endif
+    }
+
+    for (auto &threadStats : stats) {
+        if (threadStats.lateStarts > 0) {
+            std::cout << "[" << threadStats.name << "] " << threadStats.lateStarts
+                      << " transactions started late, replay could not keep up with the recorded timing" << std::endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,392 @@
+#include "utils.hh"
+
+#include <Tecs.hh>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace testing;
+
+/**
+ * Measures how the cost of common operations grows with the size of the world, so that super-linear costs show up
+ * before a real world grows into them.
+ *
+ * A fresh ECS is populated for every combination of entity count, component size, and component density. Each world
+ * then measures iterating all components, random point access, writing a fraction of the components along with the
+ * commit that follows, and a small AddRemove commit. Worlds whose estimated storage would exceed the memory limit are
+ * skipped.
+ *
+ * Results are written as one row per measurement to <output_prefix>.csv and <output_prefix>.json. A scaling exponent
+ * is fitted to each operation's cost across entity counts, and any above SCALING_SUPERLINEAR_EXPONENT are reported
+ * at the end.
+ *
+ * Usage: Tecs-scaling [max_entity_count] [memory_limit_mb] [output_prefix]
+ */
+
+// Minimum total time and sample counts for each repeated measurement
+#ifndef SCALING_MIN_SAMPLE_MS
+    #define SCALING_MIN_SAMPLE_MS 100
+#endif
+#ifndef SCALING_MIN_SAMPLES
+    #define SCALING_MIN_SAMPLES 3
+#endif
+#ifndef SCALING_MAX_SAMPLES
+    #define SCALING_MAX_SAMPLES 100
+#endif
+// Number of random component lookups per point access sample
+#ifndef SCALING_POINT_LOOKUPS
+    #define SCALING_POINT_LOOKUPS 10000
+#endif
+// Number of entities removed and recreated by each AddRemove sample
+#ifndef SCALING_ADD_REMOVE_COUNT
+    #define SCALING_ADD_REMOVE_COUNT 100
+#endif
+// Fitted scaling exponent above which an operation is reported as super-linear. Cache effects alone push linear
+// operations somewhat above 1.0 once the working set outgrows each cache level.
+#ifndef SCALING_SUPERLINEAR_EXPONENT
+    #define SCALING_SUPERLINEAR_EXPONENT 1.5
+#endif
+
+#define DEFAULT_MAX_ENTITY_COUNT 10000000
+#define DEFAULT_MEMORY_LIMIT_MB 2048
+#define DEFAULT_OUTPUT_PREFIX "scaling"
+
+namespace scaling {
+    template<size_t Size>
+    struct Payload {
+        uint8_t data[Size];
+    };
+
+    // Storage is allocated for every component type whenever new entities are allocated, so each component size gets
+    // its own ECS type to keep the other sizes from being included in the measurements.
+    template<size_t Size>
+    using ECS = Tecs::ECS<Payload<Size>>;
+
+    const std::vector<size_t> entityCounts = {1000, 10000, 100000, 1000000, 10000000};
+    const std::vector<double> densities = {0.001, 0.01, 0.1, 1.0};
+    const std::vector<double> writeFractions = {0.01, 0.1, 1.0};
+
+    struct Result {
+        std::string operation;
+        size_t entityCount;
+        size_t componentBytes;
+        double density;
+        // Zero for operations that don't depend on the write fraction
+        double writeFraction;
+        // Number of components or entities processed by each sample
+        size_t elements;
+        size_t samples;
+        double avgNs;
+        double minNs;
+    };
+
+    std::vector<Result> results;
+    // Keeps reads from being optimized away
+    uint64_t checksum = 0;
+
+    struct Samples {
+        std::vector<std::chrono::nanoseconds> values;
+
+        void AddValue(std::chrono::nanoseconds value) {
+            values.emplace_back(value);
+        }
+
+        double Avg() const {
+            std::chrono::nanoseconds total(0);
+            for (auto &value : values) {
+                total += value;
+            }
+            return values.empty() ? 0.0 : (double)total.count() / values.size();
+        }
+
+        double Min() const {
+            return values.empty() ? 0.0 : (double)std::min_element(values.begin(), values.end())->count();
+        }
+    };
+
+    // Calls sample until it has run for at least SCALING_MIN_SAMPLE_MS and SCALING_MIN_SAMPLES times.
+    void Repeat(const std::function<void(Samples &)> &sample, Samples &samples) {
+        auto start = std::chrono::steady_clock::now();
+        auto minTime = std::chrono::milliseconds(SCALING_MIN_SAMPLE_MS);
+        while (samples.values.size() < SCALING_MAX_SAMPLES &&
+               (samples.values.size() < SCALING_MIN_SAMPLES || std::chrono::steady_clock::now() - start < minTime)) {
+            sample(samples);
+        }
+    }
+
+    void AddResult(const std::string &operation,
+        size_t entityCount,
+        size_t componentBytes,
+        double density,
+        double writeFraction,
+        size_t elements,
+        const Samples &samples) {
+        auto &result = results.emplace_back(Result{operation,
+            entityCount,
+            componentBytes,
+            density,
+            writeFraction,
+            elements,
+            samples.values.size(),
+            samples.Avg(),
+            samples.Min()});
+
+        std::stringstream ss;
+        ss << "[" << operation << " " << entityCount << " entities, " << componentBytes << " bytes, density "
+           << density;
+        if (writeFraction > 0) ss << ", write fraction " << writeFraction;
+        ss << "] Avg: " << (result.avgNs / 1000.0) << " usec, Min: " << (result.minNs / 1000.0) << " usec";
+        if (elements > 0) ss << ", " << (result.avgNs / elements) << " ns per element";
+        ss << std::endl;
+        std::cout << ss.str();
+    }
+
+    // Returns true if entity index i has a component, spreading density * entityCount components evenly.
+    inline bool HasComponent(size_t i, double density) {
+        return (size_t)((double)(i + 1) * density) != (size_t)((double)i * density);
+    }
+
+    template<size_t Size>
+    void RunWorld(size_t entityCount, double density) {
+        using T = Payload<Size>;
+        auto ecs = std::make_unique<ECS<Size>>();
+
+        {
+            Samples samples;
+            auto start = std::chrono::steady_clock::now();
+            {
+                auto lock = ecs->template StartTransaction<Tecs::AddRemove>();
+                for (size_t i = 0; i < entityCount; i++) {
+                    auto e = lock.NewEntity();
+                    if (HasComponent(i, density)) e.template Set<T>(lock, T{});
+                }
+            }
+            samples.AddValue(std::chrono::steady_clock::now() - start);
+            AddResult("create", entityCount, Size, density, 0, entityCount, samples);
+        }
+
+        size_t componentCount;
+        std::vector<Tecs::Entity> lookups;
+        {
+            auto lock = ecs->template StartTransaction<Tecs::Read<T>>();
+            auto &entities = lock.template EntitiesWith<T>();
+            componentCount = entities.size();
+            if (componentCount == 0) return;
+
+            std::mt19937 rand(entityCount);
+            std::uniform_int_distribution<size_t> pick(0, componentCount - 1);
+            lookups.reserve(SCALING_POINT_LOOKUPS);
+            for (size_t i = 0; i < SCALING_POINT_LOOKUPS; i++) {
+                lookups.emplace_back(entities[pick(rand)]);
+            }
+        }
+
+        {
+            Samples samples;
+            Repeat(
+                [&](Samples &samples) {
+                    auto lock = ecs->template StartTransaction<Tecs::Read<T>>();
+                    auto start = std::chrono::steady_clock::now();
+                    for (auto e : lock.template EntitiesWith<T>()) {
+                        checksum += e.template Get<T>(lock).data[0];
+                    }
+                    samples.AddValue(std::chrono::steady_clock::now() - start);
+                },
+                samples);
+            AddResult("iterate", entityCount, Size, density, 0, componentCount, samples);
+        }
+
+        {
+            Samples samples;
+            Repeat(
+                [&](Samples &samples) {
+                    auto lock = ecs->template StartTransaction<Tecs::Read<T>>();
+                    auto start = std::chrono::steady_clock::now();
+                    for (auto e : lookups) {
+                        checksum += e.template Get<T>(lock).data[Size - 1];
+                    }
+                    samples.AddValue(std::chrono::steady_clock::now() - start);
+                },
+                samples);
+            AddResult("point_access", entityCount, Size, density, 0, lookups.size(), samples);
+        }
+
+        for (double writeFraction : writeFractions) {
+            size_t stride = std::max((size_t)1, (size_t)std::llround(1.0 / writeFraction));
+            size_t writeCount = (componentCount + stride - 1) / stride;
+
+            Samples writeSamples, commitSamples;
+            Repeat(
+                [&](Samples &samples) {
+                    std::chrono::steady_clock::time_point commitStart;
+                    {
+                        auto lock = ecs->template StartTransaction<Tecs::Write<T>>();
+                        auto start = std::chrono::steady_clock::now();
+                        auto &entities = lock.template EntitiesWith<T>();
+                        for (size_t i = 0; i < entities.size(); i += stride) {
+                            entities[i].template Get<T>(lock).data[0]++;
+                        }
+                        commitStart = std::chrono::steady_clock::now();
+                        samples.AddValue(commitStart - start);
+                    }
+                    commitSamples.AddValue(std::chrono::steady_clock::now() - commitStart);
+                },
+                writeSamples);
+            AddResult("write", entityCount, Size, density, writeFraction, writeCount, writeSamples);
+            AddResult("commit", entityCount, Size, density, writeFraction, writeCount, commitSamples);
+        }
+
+        {
+            // Remove and recreate a fixed number of entities, so any cost that grows with the world size comes from
+            // rescanning unchanged entities.
+            size_t changeCount = std::min((size_t)SCALING_ADD_REMOVE_COUNT, componentCount);
+            Samples samples;
+            Repeat(
+                [&](Samples &samples) {
+                    std::chrono::steady_clock::time_point commitStart;
+                    {
+                        auto lock = ecs->template StartTransaction<Tecs::AddRemove>();
+                        auto &entities = lock.template EntitiesWith<T>();
+                        std::vector<Tecs::Entity> removed;
+                        for (size_t i = 0; i < changeCount; i++) {
+                            removed.emplace_back(entities[i]);
+                        }
+                        for (auto e : removed) {
+                            e.Destroy(lock);
+                        }
+                        for (size_t i = 0; i < changeCount; i++) {
+                            lock.NewEntity().template Set<T>(lock, T{});
+                        }
+                        commitStart = std::chrono::steady_clock::now();
+                    }
+                    samples.AddValue(std::chrono::steady_clock::now() - commitStart);
+                },
+                samples);
+            AddResult("add_remove_commit", entityCount, Size, density, 0, changeCount, samples);
+        }
+    }
+
+    template<size_t Size>
+    void RunSize(size_t maxEntityCount, size_t memoryLimitMb) {
+        for (size_t entityCount : entityCounts) {
+            if (entityCount > maxEntityCount) break;
+            // Component storage is indexed by entity, so it grows with the world size regardless of density. The
+            // per-entity overhead covers metadata and the valid entity lists, and is only a rough estimate.
+            // Storage reallocation briefly needs more than this.
+            double estimatedMb = (double)entityCount * (Size * 2 + 64) / (1024 * 1024);
+            if (estimatedMb > memoryLimitMb) {
+                std::cout << "[Skipped " << entityCount << " entities, " << Size << " bytes] Estimated "
+                          << (size_t)estimatedMb << " MB exceeds memory limit" << std::endl;
+                continue;
+            }
+            for (double density : densities) {
+                RunWorld<Size>(entityCount, density);
+            }
+        }
+    }
+
+    void SaveCSV(std::ostream &out) {
+        out << "Operation,Entity Count,Component Bytes,Density,Write Fraction,Elements,Samples,Avg Ns,Min Ns,"
+               "Ns Per Element"
+            << std::endl;
+        for (auto &result : results) {
+            out << result.operation << "," << result.entityCount << "," << result.componentBytes << ","
+                << result.density << "," << result.writeFraction << "," << result.elements << "," << result.samples
+                << "," << result.avgNs << "," << result.minNs << ","
+                << (result.elements > 0 ? result.avgNs / result.elements : 0.0) << std::endl;
+        }
+    }
+
+    void SaveJSON(std::ostream &out) {
+        out << "[" << std::endl;
+        for (size_t i = 0; i < results.size(); i++) {
+            auto &result = results[i];
+            out << "  {\"operation\":\"" << result.operation << "\",\"entityCount\":" << result.entityCount
+                << ",\"componentBytes\":" << result.componentBytes << ",\"density\":" << result.density
+                << ",\"writeFraction\":" << result.writeFraction << ",\"elements\":" << result.elements
+                << ",\"samples\":" << result.samples << ",\"avgNs\":" << result.avgNs
+                << ",\"minNs\":" << result.minNs
+                << ",\"nsPerElement\":" << (result.elements > 0 ? result.avgNs / result.elements : 0.0) << "}"
+                << (i + 1 < results.size() ? "," : "") << std::endl;
+        }
+        out << "]" << std::endl;
+    }
+
+    // Fits a scaling exponent to each series of measurements and returns the number of super-linear series.
+    size_t ReportSuperLinear() {
+        using SeriesKey = std::tuple<std::string, size_t, double, double>;
+        std::map<SeriesKey, std::vector<const Result *>> series;
+        for (auto &result : results) {
+            // Short measurements are dominated by noise and fixed overhead
+            if (result.avgNs < 10000.0) continue;
+            series[{result.operation, result.componentBytes, result.density, result.writeFraction}].push_back(&result);
+        }
+
+        size_t count = 0;
+        for (auto &[key, points] : series) {
+            if (points.size() < 3) continue;
+
+            // Least squares slope of log(time) against log(entity count)
+            double sumX = 0, sumY = 0, sumXX = 0, sumXY = 0;
+            for (auto *point : points) {
+                double x = std::log((double)point->entityCount);
+                double y = std::log(point->avgNs);
+                sumX += x;
+                sumY += y;
+                sumXX += x * x;
+                sumXY += x * y;
+            }
+            double n = (double)points.size();
+            double exponent = (n * sumXY - sumX * sumY) / (n * sumXX - sumX * sumX);
+            if (exponent > SCALING_SUPERLINEAR_EXPONENT) {
+                auto &first = *points.front();
+                std::cout << "[Super-linear] " << first.operation << " " << first.componentBytes << " bytes, density "
+                          << first.density;
+                if (first.writeFraction > 0) std::cout << ", write fraction " << first.writeFraction;
+                std::cout << ": exponent " << std::setprecision(3) << exponent << std::setprecision(6) << " from "
+                          << first.entityCount << " to " << points.back()->entityCount << " entities" << std::endl;
+                count++;
+            }
+        }
+        return count;
+    }
+} // namespace scaling
+
+int main(int argc, char **argv) {
+    size_t maxEntityCount = argc > 1 ? std::stoull(argv[1]) : DEFAULT_MAX_ENTITY_COUNT;
+    size_t memoryLimitMb = argc > 2 ? std::stoull(argv[2]) : DEFAULT_MEMORY_LIMIT_MB;
+    std::string outputPrefix = argc > 3 ? argv[3] : DEFAULT_OUTPUT_PREFIX;
+
+    {
+        Timer t("Scaling sweep up to " + std::to_string(maxEntityCount) + " entities");
+        scaling::RunSize<4>(maxEntityCount, memoryLimitMb);
+        scaling::RunSize<64>(maxEntityCount, memoryLimitMb);
+        scaling::RunSize<512>(maxEntityCount, memoryLimitMb);
+        scaling::RunSize<4096>(maxEntityCount, memoryLimitMb);
+    }
+
+    std::ofstream csvFile(outputPrefix + ".csv");
+    scaling::SaveCSV(csvFile);
+    std::ofstream jsonFile(outputPrefix + ".json");
+    scaling::SaveJSON(jsonFile);
+    std::cout << "Results saved to " << outputPrefix << ".csv and " << outputPrefix << ".json (checksum "
+              << scaling::checksum << ")" << std::endl;
+
+    size_t superLinear = scaling::ReportSuperLinear();
+    if (superLinear == 0) {
+        std::cout << "No super-linear scaling detected" << std::endl;
+    }
+    return 0;
+}
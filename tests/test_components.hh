@@ -11,12 +11,17 @@
 
 namespace testing {
     struct Script {
-        std::vector<uint32_t> data;
+        std::vector<uint32_t, Tecs::ComponentAllocator<uint32_t, Script>> data;
         std::shared_ptr<std::string> filename;
 
         Script() {}
         Script(uint32_t *data, size_t size) : data(data, data + size) {}
         Script(std::initializer_list<uint32_t> init) : data(init) {}
+
+        void clear() {
+            data.clear();
+            filename.reset();
+        }
     };
 
     struct Renderable {
@@ -33,4 +38,32 @@ namespace testing {
         GlobalComponent() : globalCounter(10) {}
         GlobalComponent(size_t initial_value) : globalCounter(initial_value) {}
     };
+
+    struct Tick {
+        size_t value = 0;
+
+        Tick() {}
+        Tick(size_t value) : value(value) {}
+    };
+
+    struct Velocity {
+        double v[3] = {0};
+
+        Velocity() {}
+        Velocity(double x, double y, double z) : v{x, y, z} {}
+    };
+
+    struct Label {
+        std::string text;
+
+        Label() {}
+        Label(std::string text) : text(text) {}
+    };
 }; // namespace testing
+
+TECS_RECYCLE_COMPONENT(testing::Script);
+TECS_COMPONENT_HISTORY(testing::Tick, 3);
+TECS_COMPONENT_HISTORY(testing::Label, 2);
+TECS_TRACK_CHANGES(testing::Tick);
+TECS_TRACK_WRITES(testing::Tick);
+TECS_LOCK_GROUP(testing::Velocity, testing::Transform);
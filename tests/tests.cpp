@@ -5,11 +5,18 @@
 #include "utils.hh"
 
 #include <Tecs.hh>
+#ifndef _WIN32
+    #include <Tecs_inspector.hh>
+    #include <Tecs_shared_memory.hh>
+    #include <unistd.h>
+#endif
+#include <algorithm>
 #include <chrono>
 #include <condition_variable>
 #include <cstring>
 #include <future>
 #include <map>
+#include <memory_resource>
 #include <mutex>
 
 using namespace testing;
@@ -1288,13 +1295,1465 @@ int main(int /* argc */, char ** /* argv */) {
             Assert(theMap[e] == 0, "Expected value to not be set");
         }
     }
+    {
+        Timer t("Test moving components in and out of storage");
+        auto filename = std::make_shared<std::string>("test.script");
+        Tecs::Observer<ECS, Tecs::ComponentEvent<Script>> scriptObserver;
+        Tecs::Entity e;
+        const uint32_t *dataPtr;
+        {
+            auto lock = ecs.StartTransaction<Tecs::AddRemove>();
+            scriptObserver = lock.Watch<Tecs::ComponentEvent<Script>>();
+
+            Script script({1, 2, 3});
+            script.filename = filename;
+            dataPtr = script.data.data();
+
+            e = lock.NewEntity();
+            auto &newScript = e.Set<Script>(lock, std::move(script));
+            Assert(newScript.data.data() == dataPtr, "Expected script data to be moved into storage");
+            Assert(filename.use_count() == 2, "Expected script filename to be moved into storage");
+        }
+        {
+            auto lock = ecs.StartTransaction<Tecs::Read<Script>>();
+            Tecs::ComponentEvent<Script> event;
+            Assert(scriptObserver.Poll(lock, event), "Expected a script event");
+            Assert(event.type == Tecs::EventType::ADDED, "Expected script event type to be ADDED");
+            Assert(event.component.filename == filename, "Expected script event to contain the new component");
+            Assert(!scriptObserver.Poll(lock, event), "Unexpected script event");
+
+            dataPtr = e.Get<Script>(lock).data.data();
+        }
+        {
+            auto lock = ecs.StartTransaction<Tecs::AddRemove>();
+            e.Destroy(lock);
+        }
+        {
+            auto lock = ecs.StartTransaction<Tecs::AddRemove>();
+            Tecs::ComponentEvent<Script> event;
+            Assert(scriptObserver.Poll(lock, event), "Expected a script event");
+            Assert(event.type == Tecs::EventType::REMOVED, "Expected script event type to be REMOVED");
+            Assert(event.component.data.data() == dataPtr, "Expected removed script to be moved into the event");
+            Assert(event.component.filename == filename, "Expected removed script to keep its filename");
+            Assert(filename.use_count() == 2, "Expected removed script filename to only be held by the event");
+            Assert(!scriptObserver.Poll(lock, event), "Unexpected script event");
+
+            scriptObserver.Stop(lock);
+        }
+    }
+    {
+        Timer t("Test recycled components keep their capacity");
+        static_assert(std::allocator_traits<decltype(Script::data)::allocator_type>::is_always_equal(),
+            "Expected pooled component memory to be moved between buffers without reallocating");
+        Tecs::Entity e;
+        {
+            auto lock = ecs.StartTransaction<Tecs::AddRemove>();
+            e = lock.NewEntity();
+            auto &script = e.Set<Script>(lock, std::initializer_list<uint32_t>({1, 2, 3}));
+            script.data.resize(100);
+            script.filename = std::make_shared<std::string>("test.script");
+        }
+        {
+            auto lock = ecs.StartTransaction<Tecs::AddRemove>();
+            e.Unset<Script>(lock);
+            Assert(!e.Has<Script>(lock), "Expected entity to not have a script");
+        }
+        {
+            auto lock = ecs.StartTransaction<Tecs::AddRemove>();
+            auto &script = e.Get<Script>(lock);
+            Assert(script.data.empty(), "Expected recycled script data to be empty");
+            Assert(script.data.capacity() >= 100, "Expected recycled script data to keep its capacity");
+            Assert(!script.filename, "Expected recycled script filename to be reset");
+            e.Destroy(lock);
+        }
+    }
+    {
+        Timer t("Test splicing entities from a staging ecs");
+        testing::ECS staging;
+        std::vector<Tecs::Entity> stagingEntities;
+        {
+            auto stagingLock = staging.StartTransaction<Tecs::AddRemove>();
+            for (size_t i = 0; i < 10; i++) {
+                Tecs::Entity e = stagingLock.NewEntity();
+                e.Set<Transform>(stagingLock, (double)i, 0.0, 0.0);
+                if (i % 2 == 0) e.Set<Renderable>(stagingLock, "entity" + std::to_string(i));
+                stagingEntities.emplace_back(e);
+            }
+            // Destroyed staging entities should not be spliced
+            Tecs::Entity destroyed = stagingEntities.back();
+            destroyed.Destroy(stagingLock);
+        }
+        std::vector<Tecs::Entity> entityMapping;
+        {
+            auto stagingLock = staging.StartTransaction<Tecs::AddRemove>();
+            auto lock = ecs.StartTransaction<Tecs::AddRemove>();
+            size_t previousCount = lock.Entities().size();
+            entityMapping = lock.Splice(stagingLock);
+            Assert(lock.Entities().size() == previousCount + 9, "Expected 9 entities to be spliced");
+            for (auto &e : stagingLock.Entities()) {
+                Assert(!e.Exists(stagingLock), "Expected staging entities to be destroyed");
+            }
+        }
+        {
+            auto lock = ecs.StartTransaction<Tecs::AddRemove>();
+            for (size_t i = 0; i < 9; i++) {
+                Tecs::Entity e = entityMapping[stagingEntities[i].index];
+                Assert(e.Has<Transform>(lock), "Expected spliced entity to have a Transform");
+                Assert(e.Get<Transform>(lock).pos[0] == (double)i, "Expected spliced Transform value to be moved");
+                Assert(e.Has<Renderable>(lock) == (i % 2 == 0), "Expected spliced entity to keep its Renderable");
+                if (i % 2 == 0) {
+                    Assert(e.Get<Renderable>(lock).name == "entity" + std::to_string(i),
+                        "Expected spliced Renderable value to be moved");
+                }
+                e.Destroy(lock);
+            }
+            Assert(!entityMapping[stagingEntities.back().index], "Expected destroyed entity not to be spliced");
+        }
+    }
+    {
+        Timer t("Test deferred writes are only visible after publishing");
+        Tecs::Entity e;
+        {
+            auto lock = ecs.StartTransaction<Tecs::AddRemove>();
+            e = lock.NewEntity();
+            e.Set<Transform>(lock, 1.0, 0.0, 0.0);
+        }
+        {
+            auto lock = ecs.StartTransaction<Tecs::WriteDeferred<Transform>>();
+            e.Get<Transform>(lock).pos[0] = 2.0;
+        }
+        {
+            auto lock = ecs.StartTransaction<Tecs::Read<Transform>>();
+            Assert(e.Get<Transform>(lock).pos[0] == 1.0, "Expected deferred write not to be visible to readers");
+        }
+        {
+            auto lock = ecs.StartTransaction<Tecs::WriteDeferred<Transform>>();
+            auto &transform = e.Get<Transform>(lock);
+            Assert(transform.pos[0] == 2.0, "Expected deferred write to be visible to the next writer");
+            Assert(e.GetPrevious<Transform>(lock).pos[0] == 1.0, "Expected previous value to be the published value");
+            transform.pos[0] = 3.0;
+        }
+        ecs.Publish<Transform>();
+        {
+            auto lock = ecs.StartTransaction<Tecs::Read<Transform>>();
+            Assert(e.Get<Transform>(lock).pos[0] == 3.0, "Expected deferred writes to be published");
+        }
+        {
+            auto lock = ecs.StartTransaction<Tecs::AddRemove>();
+            e.Destroy(lock);
+        }
+    }
+    {
+        Timer t("Test async commit");
+        Tecs::Entity e;
+        std::shared_future<void> committed;
+        {
+            auto lock = ecs.StartTransaction<Tecs::AddRemove>();
+            e = lock.NewEntity();
+            e.Set<Transform>(lock, 1.0, 0.0, 0.0);
+            committed = lock.AsyncCommit();
+        }
+        committed.get();
+        {
+            auto lock = ecs.StartTransaction<Tecs::Write<Transform>>();
+            Assert(e.Exists(lock), "Expected async committed entity to exist");
+            Assert(e.Get<Transform>(lock).pos[0] == 1.0, "Expected async committed value to be visible");
+            e.Get<Transform>(lock).pos[0] = 2.0;
+            committed = lock.AsyncCommit();
+        }
+        committed.get();
+        {
+            auto lock = ecs.StartTransaction<Tecs::Read<Transform>>();
+            Assert(e.Get<Transform>(lock).pos[0] == 2.0, "Expected async committed write to be visible");
+            committed = lock.AsyncCommit();
+        }
+        Assert(committed.wait_for(std::chrono::seconds(0)) == std::future_status::ready,
+            "Expected read only transaction to commit immediately");
+        {
+            auto lock = ecs.StartTransaction<Tecs::AddRemove>();
+            e.Destroy(lock);
+            lock.AsyncCommit();
+        }
+    }
+    {
+        Timer t("Test yielding read locks to a pending commit");
+        Tecs::Entity e;
+        {
+            auto lock = ecs.StartTransaction<Tecs::AddRemove>();
+            e = lock.NewEntity();
+            e.Set<Transform>(lock, 1.0, 0.0, 0.0);
+        }
+        {
+            auto readLock = ecs.StartTransaction<Tecs::Read<Transform>>();
+            Assert(!readLock.CommitPending<Transform>(), "Expected no commit to be pending");
+
+            auto writer = std::async(std::launch::async, [&e] {
+                auto lock = ecs.StartTransaction<Tecs::Write<Transform>>();
+                e.Get<Transform>(lock).pos[0] = 2.0;
+            });
+            while (!readLock.CommitPending<Transform>()) {
+                std::this_thread::yield();
+            }
+            Assert(e.Get<Transform>(readLock).pos[0] == 1.0, "Expected pending commit not to be visible");
+
+            readLock.Yield();
+            Assert(e.Get<Transform>(readLock).pos[0] == 2.0, "Expected commit to complete while yielding");
+            writer.get();
+        }
+        {
+            auto lock = ecs.StartTransaction<Tecs::AddRemove>();
+            e.Destroy(lock);
+        }
+    }
+    {
+        Timer t("Test resuming entity cursors across transactions");
+        std::vector<Tecs::Entity> created;
+        {
+            auto lock = ecs.StartTransaction<Tecs::AddRemove>();
+            for (size_t i = 0; i < 64; i++) {
+                auto e = lock.NewEntity();
+                e.Set<Transform>(lock, (double)i, 0.0, 0.0);
+                created.emplace_back(e);
+            }
+        }
+
+        Tecs::EntityCursor<Transform> cursor;
+        std::vector<Tecs::Entity> visited;
+        std::vector<Tecs::Entity> added;
+        while (!cursor.Done()) {
+            {
+                auto lock = ecs.StartTransaction<Tecs::Read<Transform>>();
+                additionalTransactionCount++;
+                auto chunk = cursor.Next(lock, 10);
+                Assert(chunk.size() <= 10, "Expected cursor chunk to be bounded");
+                for (auto &e : chunk) {
+                    Assert(e.Has<Transform>(lock), "Expected cursor entities to have a Transform");
+                    visited.emplace_back(e);
+                }
+            }
+            if (added.empty()) {
+                // Modify the entity set between chunks
+                auto lock = ecs.StartTransaction<Tecs::AddRemove>();
+                created[2].Destroy(lock);
+                created[50].Destroy(lock);
+                for (size_t i = 0; i < 3; i++) {
+                    auto e = lock.NewEntity();
+                    e.Set<Transform>(lock, 0.0, 0.0, 0.0);
+                    added.emplace_back(e);
+                }
+            }
+        }
+        {
+            auto lock = ecs.StartTransaction<Tecs::Read<Transform>>();
+            Assert(cursor.Next(lock, 10).empty(), "Expected cursor to be exhausted");
+        }
+        {
+            // Entities added past the cursor after its last chunk are still returned, even with an unbounded count.
+            Tecs::ECS<Transform> cursorEcs;
+            {
+                auto lock = cursorEcs.StartTransaction<Tecs::AddRemove>();
+                for (size_t i = 0; i < 3; i++) {
+                    lock.NewEntity().Set<Transform>(lock, (double)i, 0.0, 0.0);
+                }
+            }
+            Tecs::EntityCursor<Transform> unbounded;
+            {
+                auto lock = cursorEcs.StartTransaction<Tecs::Read<Transform>>();
+                Assert(unbounded.Next(lock, SIZE_MAX).size() == 3, "Expected all entities in one chunk");
+                Assert(!unbounded.Done(), "Expected cursor to wait for an empty chunk");
+            }
+            Tecs::Entity late;
+            {
+                auto lock = cursorEcs.StartTransaction<Tecs::AddRemove>();
+                late = lock.NewEntity();
+                late.Set<Transform>(lock, 3.0, 0.0, 0.0);
+            }
+            {
+                auto lock = cursorEcs.StartTransaction<Tecs::Read<Transform>>();
+                auto chunk = unbounded.Next(lock, SIZE_MAX);
+                Assert(chunk.size() == 1 && *chunk.begin() == late, "Expected entity added past the cursor");
+                Assert(unbounded.Next(lock, SIZE_MAX).empty(), "Expected cursor to be exhausted");
+                Assert(unbounded.Done(), "Expected cursor to be done after an empty chunk");
+            }
+            additionalTransactionCount += 4;
+        }
+
+        std::sort(visited.begin(), visited.end());
+        Assert(std::adjacent_find(visited.begin(), visited.end()) == visited.end(),
+            "Expected each entity to be visited at most once");
+        for (size_t i = 0; i < created.size(); i++) {
+            bool found = std::binary_search(visited.begin(), visited.end(), created[i]);
+            if (i == 50) {
+                Assert(!found, "Expected entity destroyed ahead of the cursor to be skipped");
+            } else if (i != 2) {
+                Assert(found, "Expected surviving entity to be visited: " + std::to_string(created[i]));
+            }
+        }
+        {
+            auto lock = ecs.StartTransaction<Tecs::AddRemove>();
+            for (auto &e : created) {
+                if (e.Exists(lock)) e.Destroy(lock);
+            }
+            for (auto &e : added) {
+                e.Destroy(lock);
+            }
+        }
+    }
+    {
+        Timer t("Test batched component access with GetMany");
+        std::vector<Tecs::Entity> targets;
+        Tecs::Entity missing;
+        {
+            auto lock = ecs.StartTransaction<Tecs::AddRemove>();
+            for (size_t i = 0; i < 32; i++) {
+                auto e = lock.NewEntity();
+                e.Set<Transform>(lock, (double)i, 0.0, 0.0);
+                targets.emplace_back(e);
+            }
+            missing = lock.NewEntity();
+        }
+        // Access entities out of storage order, as when following references
+        std::reverse(targets.begin(), targets.end());
+        {
+            auto lock = ecs.StartTransaction<Tecs::Write<Transform>>();
+            size_t i = 0;
+            lock.GetMany<Transform>(targets, [&](const Tecs::Entity &e, Transform &transform) {
+                Assert(e == targets[i++], "Expected GetMany to visit entities in order");
+                transform.pos[1] = transform.pos[0] * 2;
+            });
+            Assert(i == targets.size(), "Expected GetMany to visit every entity");
+        }
+        {
+            auto lock = ecs.StartTransaction<Tecs::Read<Transform>>();
+            double sum = 0.0;
+            lock.GetMany<Transform>(Tecs::EntityView(targets).subview(8),
+                [&](const Tecs::Entity &, const Transform &transform) {
+                    sum += transform.pos[1];
+                });
+            // Entities 0 through 23 remain after skipping the first 8 reversed targets
+            Assert(sum == 2.0 * (23 * 24 / 2), "Expected GetMany to read committed components");
+#ifndef TECS_UNCHECKED_MODE
+            auto invalidTargets = targets;
+            invalidTargets.emplace_back(missing);
+            size_t calls = 0;
+            try {
+                lock.GetMany<Transform>(invalidTargets, [&](const Tecs::Entity &, const Transform &) {
+                    calls++;
+                });
+                Assert(false, "GetMany() on missing component should fail");
+            } catch (std::runtime_error &e) {
+                std::string msg = e.what();
+                auto compare = std::string("Entity does not have a component of type: ") + typeid(Transform).name();
+                Assert(msg == compare, "Received wrong runtime_error: " + msg);
+            }
+            Assert(calls == 0, "Expected GetMany to validate entities before any callbacks");
+#endif
+        }
+        {
+            auto lock = ecs.StartTransaction<Tecs::AddRemove>();
+            for (auto &e : targets) {
+                e.Destroy(lock);
+            }
+            missing.Destroy(lock);
+        }
+    }
+    {
+        Timer t("Test transactions with runtime permissions");
+        Tecs::Entity e;
+        {
+            std::bitset<1 + ECS::GetComponentCount()> writeBits;
+            writeBits[0] = true;
+            auto lock = ecs.StartTransaction({}, writeBits);
+            auto addRemoveLock = lock.TryLock<Tecs::AddRemove>();
+            Assert(addRemoveLock.has_value(), "Expected dynamic AddRemove transaction to allow AddRemove");
+            e = addRemoveLock->NewEntity();
+            e.Set<Transform>(*addRemoveLock, 1.0, 2.0, 3.0);
+            e.Set<Renderable>(*addRemoveLock, "dynamic");
+        }
+        {
+            using ReadTransformWriteRenderable = Tecs::Lock<ECS, Tecs::Read<Transform>, Tecs::Write<Renderable>>;
+            auto readBits = Tecs::DynamicLock<ECS>::generateReadBitset<ReadTransformWriteRenderable>();
+            std::bitset<1 + ECS::GetComponentCount()> writeBits;
+            writeBits[1 + ECS::GetComponentIndex<Renderable>()] = true;
+            Assert(writeBits == Tecs::DynamicLock<ECS>::generateWriteBitset<ReadTransformWriteRenderable>(),
+                "Expected generated write bitset to match");
+
+            auto lock = ecs.StartTransaction(readBits, writeBits);
+            Assert(!lock.TryLock<Tecs::AddRemove>(), "Expected dynamic transaction not to allow AddRemove");
+            Assert(!lock.TryLock<Tecs::Write<Transform>>(),
+                "Expected dynamic transaction not to allow Write<Transform>");
+            Assert(!lock.TryLock<Tecs::Read<Script>>(), "Expected dynamic transaction not to allow Read<Script>");
+
+            auto readLock = lock.TryLock<Tecs::Read<Transform>>();
+            Assert(readLock.has_value(), "Expected dynamic transaction to allow Read<Transform>");
+            Assert(e.Get<Transform>(*readLock).pos[1] == 2.0, "Expected dynamic transaction to read Transform");
+
+            auto writeLock = lock.TryLock<Tecs::Write<Renderable>>();
+            Assert(writeLock.has_value(), "Expected dynamic transaction to allow Write<Renderable>");
+            e.Get<Renderable>(*writeLock).name = "updated";
+
+            // Components outside of the dynamic permissions are not locked
+            auto other = std::async(std::launch::async, [] {
+                auto otherLock = ecs.StartTransaction<Tecs::Write<Transform, Script>>();
+            });
+            Assert(other.wait_for(std::chrono::seconds(10)) == std::future_status::ready,
+                "Expected unrelated transaction not to block");
+        }
+        {
+            auto lock = ecs.StartTransaction<Tecs::AddRemove>();
+            Assert(e.Get<Renderable>(lock).name == "updated", "Expected dynamic write to be committed");
+            e.Destroy(lock);
+        }
+    }
+    {
+        Timer t("Test runtime registered dynamic components");
+        using DynamicECS = Tecs::ECS<Transform, Tecs::DynamicComponent<0>, Tecs::DynamicComponent<1, sizeof(int32_t)>>;
+        static_assert(std::is_nothrow_move_constructible<Tecs::DynamicComponent<0>>(),
+            "Dynamic components must not copy when storage is resized");
+        static_assert(sizeof(Tecs::DynamicComponent<1, sizeof(int32_t)>) <= 2 * alignof(std::max_align_t),
+            "Expected small dynamic component slots to only store the value and its type");
+        DynamicECS dynamicEcs;
+        Tecs::DynamicComponentRegistry<DynamicECS> registry;
+
+        size_t nameIndex = registry.Register(Tecs::DynamicComponentType::Of<std::string>("name"));
+        size_t healthIndex = registry.Register(Tecs::DynamicComponentType::Bytes("health", sizeof(int32_t)));
+        Assert(nameIndex == 1 && healthIndex == 2, "Expected dynamic components to be assigned in slot order");
+        Assert(registry.Find("health") == healthIndex, "Expected to find dynamic component by name");
+        try {
+            registry.Register(Tecs::DynamicComponentType::Bytes("armor", sizeof(int32_t)));
+            Assert(false, "Registering more dynamic components than slots should fail");
+        } catch (std::runtime_error &e) {
+            std::string msg = e.what();
+            Assert(msg == "No free DynamicComponent slots to register type: armor", "Received wrong error: " + msg);
+        }
+
+        Tecs::Entity e;
+        {
+            std::bitset<1 + DynamicECS::GetComponentCount()> writeBits;
+            writeBits[0] = true;
+            auto lock = dynamicEcs.StartTransaction({}, writeBits);
+            e = lock.TryLock<Tecs::AddRemove>()->NewEntity();
+            *static_cast<std::string *>(registry.Set(lock, e, nameIndex)) = "orc";
+            *static_cast<int32_t *>(registry.Set(lock, e, healthIndex)) = 100;
+        }
+        {
+            std::bitset<1 + DynamicECS::GetComponentCount()> readBits;
+            readBits[1 + nameIndex] = true;
+            auto lock = dynamicEcs.StartTransaction(readBits, {});
+            Assert(registry.Has(lock, e, nameIndex), "Expected entity to have a name component");
+            Assert(registry.Has(lock, e, healthIndex), "Expected entity to have a health component");
+            auto name = static_cast<const std::string *>(registry.Get(lock, e, nameIndex));
+            Assert(*name == "orc", "Expected dynamic name component to be committed");
+            try {
+                registry.Get(lock, e, healthIndex);
+                Assert(false, "Reading a dynamic component without permissions should fail");
+            } catch (std::runtime_error &e) {
+                std::string msg = e.what();
+                Assert(msg == "Lock does not have read permissions for dynamic component: health",
+                    "Received wrong error: " + msg);
+            }
+
+            // Dynamic component slots are iterated like static components
+            auto readLock = lock.TryLock<Tecs::Read<Tecs::DynamicComponent<0>>>();
+            auto &entities = readLock->EntitiesWith<Tecs::DynamicComponent<0>>();
+            Assert(entities.size() == 1, "Expected one entity with a name component");
+            auto &value = entities[0].Get<Tecs::DynamicComponent<0>>(*readLock);
+            Assert(value.Get<std::string>() == "orc", "Expected to read the name component natively");
+        }
+        {
+            auto lock = dynamicEcs.StartTransaction<Tecs::AddRemove>();
+            Tecs::DynamicLock<DynamicECS, Tecs::AddRemove> dynamicLock = lock;
+            registry.Unset(dynamicLock, e, nameIndex);
+            Assert(!e.Has<Tecs::DynamicComponent<0>>(lock), "Expected name component to be removed");
+            e.Destroy(lock);
+        }
+
+        // Types that don't fit in any free slot are rejected instead of being allocated separately
+        struct LargeComponent {
+            uint64_t values[64];
+        };
+        Tecs::DynamicComponentRegistry<DynamicECS> largeRegistry;
+        auto largeType = Tecs::DynamicComponentType::Of<LargeComponent>("large");
+        Assert(!Tecs::DynamicComponent<0>::StoresInline(largeType), "Expected large type not to fit in the slot");
+        try {
+            largeRegistry.Register(largeType);
+            Assert(false, "Registering a type larger than every free slot should fail");
+        } catch (std::runtime_error &e) {
+            std::string msg = e.what();
+            Assert(msg == "No free DynamicComponent slot can store type inline: large", "Received wrong error: " + msg);
+        }
+        try {
+            Tecs::DynamicComponent<0> value(largeType);
+            Assert(false, "Storing a type larger than the slot should fail");
+        } catch (std::runtime_error &e) {
+            std::string msg = e.what();
+            Assert(msg == "Dynamic component type does not fit in slot: large", "Received wrong error: " + msg);
+        }
+
+        Assert(largeRegistry.Register(Tecs::DynamicComponentType::Bytes("wide", 32)) == 1,
+            "Expected wide type to use the only slot it fits in");
+        try {
+            largeRegistry.Register(Tecs::DynamicComponentType::Bytes("wider", 32));
+            Assert(false, "Registering a type larger than every free slot should fail");
+        } catch (std::runtime_error &e) {
+            std::string msg = e.what();
+            Assert(msg == "No free DynamicComponent slot can store type inline: wider", "Received wrong error: " + msg);
+        }
+    }
+    {
+        Timer t("Test flyweight components share interned values");
+        using MeshName = Tecs::Flyweight<std::string>;
+        using FlyweightECS = Tecs::ECS<Transform, MeshName>;
+        FlyweightECS flyweightEcs;
+
+        std::vector<Tecs::Entity> entities;
+        {
+            auto lock = flyweightEcs.StartTransaction<Tecs::AddRemove>();
+            for (size_t i = 0; i < 100; i++) {
+                auto e = lock.NewEntity();
+                e.Set<MeshName>(lock, i % 2 == 0 ? "cube" : "sphere");
+                entities.emplace_back(e);
+            }
+        }
+        Assert(MeshName::InternedCount() == 2, "Expected flyweight values to be deduplicated");
+        {
+            auto lock = flyweightEcs.StartTransaction<Tecs::Read<MeshName>>();
+            auto &cube = entities[0].Get<MeshName>(lock);
+            Assert(*cube == "cube", "Expected flyweight value to be committed");
+            Assert(&cube.Get() == &entities[2].Get<MeshName>(lock).Get(), "Expected equal values to be shared");
+            Assert(cube != entities[1].Get<MeshName>(lock), "Expected different values not to be shared");
+        }
+        {
+            auto lock = flyweightEcs.StartTransaction<Tecs::Write<MeshName>>();
+            entities[1].Set<MeshName>(lock, std::string("cube"));
+            Assert(entities[0].Get<MeshName>(lock) == entities[1].Get<MeshName>(lock),
+                "Expected new value to reference the existing interned value");
+        }
+        {
+            // Threads interning the same values concurrently must still share a single instance of each.
+            std::vector<std::future<std::vector<MeshName>>> interners;
+            for (size_t i = 0; i < 4; i++) {
+                interners.emplace_back(std::async(std::launch::async, [] {
+                    std::vector<MeshName> names;
+                    for (size_t j = 0; j < 1000; j++) {
+                        names.emplace_back("mesh" + std::to_string(j % 50));
+                    }
+                    return names;
+                }));
+            }
+            std::vector<std::vector<MeshName>> results;
+            for (auto &interner : interners) {
+                results.emplace_back(interner.get());
+            }
+            Assert(MeshName::InternedCount() == 52, "Expected concurrently interned values to be deduplicated");
+            for (auto &names : results) {
+                for (size_t j = 0; j < names.size(); j++) {
+                    Assert(names[j] == results[0][j], "Expected concurrently interned values to be shared");
+                }
+            }
+        }
+        {
+            auto lock = flyweightEcs.StartTransaction<Tecs::AddRemove>();
+            for (auto &e : entities) {
+                e.Destroy(lock);
+            }
+        }
+    }
+    Assert(Tecs::Flyweight<std::string>::InternedCount() == 0, "Expected interned values to be freed with the ECS");
+    {
+        Timer t("Test reading component history");
+        using HistoryECS = Tecs::ECS<Transform, Tick>;
+        HistoryECS historyEcs;
+
+        Tecs::Entity a, b;
+        {
+            auto lock = historyEcs.StartTransaction<Tecs::AddRemove>();
+            a = lock.NewEntity();
+            a.Set<Tick>(lock, 0);
+            b = lock.NewEntity();
+            b.Set<Tick>(lock, 100);
+        }
+        for (size_t tick = 1; tick <= 4; tick++) {
+            auto lock = historyEcs.StartTransaction<Tecs::Write<Tick>>();
+            a.Get<Tick>(lock).value = tick;
+            b.Get<Tick>(lock).value = 100 + tick;
+        }
+        {
+            auto lock = historyEcs.StartTransaction<Tecs::Read<Tick>>();
+            Assert(lock.HistorySize<Tick>() == 3, "Expected history to be limited to its depth");
+            for (size_t ticksAgo = 0; ticksAgo <= 3; ticksAgo++) {
+                Assert(lock.GetHistory<Tick>(a, ticksAgo).value == 4 - ticksAgo, "Expected historical value");
+                Assert(lock.GetHistory<Tick>(b, ticksAgo).value == 104 - ticksAgo, "Expected historical value");
+            }
+#ifndef TECS_UNCHECKED_MODE
+            try {
+                lock.GetHistory<Tick>(a, 4);
+                Assert(false, "Reading past the history depth should fail");
+            } catch (std::runtime_error &e) {
+                std::string msg = e.what();
+                Assert(msg.rfind("Component history only contains 3 commits", 0) == 0,
+                    "Received wrong runtime_error: " + msg);
+            }
+#endif
+        }
+        Tecs::Entity c;
+        {
+            // Grow the storage so that recycled history buffers are smaller than the read buffer.
+            auto lock = historyEcs.StartTransaction<Tecs::AddRemove>();
+            for (size_t i = 0; i < 100; i++) {
+                lock.NewEntity().Set<Transform>(lock);
+            }
+            c = lock.NewEntity();
+            c.Set<Tick>(lock, 200);
+        }
+        {
+            auto lock = historyEcs.StartTransaction<Tecs::Write<Tick>>();
+            c.Get<Tick>(lock).value = 201;
+        }
+        {
+            auto lock = historyEcs.StartTransaction<Tecs::Read<Tick>>();
+            Assert(lock.GetHistory<Tick>(c, 0).value == 201, "Expected current value");
+            Assert(lock.GetHistory<Tick>(c, 1).value == 200, "Expected value from previous commit");
+            Assert(lock.GetHistory<Tick>(a, 2).value == 4, "Expected value from before the entity was added");
+        }
+
+        // Removed values stay in the history when they are also sent to observers.
+        using LabelECS = Tecs::ECS<Label>;
+        LabelECS labelEcs;
+        Tecs::Observer<LabelECS, Tecs::ComponentEvent<Label>> labelObserver;
+        Tecs::Entity labeled;
+        {
+            auto lock = labelEcs.StartTransaction<Tecs::AddRemove>();
+            labelObserver = lock.Watch<Tecs::ComponentEvent<Label>>();
+            labeled = lock.NewEntity();
+            labeled.Set<Label>(lock, "removed label");
+        }
+        {
+            auto lock = labelEcs.StartTransaction<Tecs::AddRemove>();
+            labeled.Unset<Label>(lock);
+        }
+        {
+            auto lock = labelEcs.StartTransaction<Tecs::AddRemove>();
+            labeled.Set<Label>(lock, "new label");
+        }
+        {
+            auto lock = labelEcs.StartTransaction<Tecs::Read<Label>>();
+            Tecs::ComponentEvent<Label> event;
+            Assert(labelObserver.Poll(lock, event), "Expected an ADDED event");
+            Assert(labelObserver.Poll(lock, event), "Expected a REMOVED event");
+            Assert(event.type == Tecs::EventType::REMOVED, "Expected component event type to be REMOVED");
+            Assert(event.component.text == "removed label", "Expected REMOVED event to contain the removed value");
+            Assert(lock.GetHistory<Label>(labeled, 0).text == "new label", "Expected current value");
+            Assert(lock.GetHistory<Label>(labeled, 2).text == "removed label",
+                "Expected removed value to be kept in history");
+        }
+    }
+    {
+        Timer t("Test restoring checkpoints");
+        using CheckpointECS = Tecs::ECS<Transform, Renderable, GlobalComponent>;
+        CheckpointECS checkpointEcs;
+
+        std::vector<Tecs::Entity> entities;
+        {
+            auto lock = checkpointEcs.StartTransaction<Tecs::AddRemove>();
+            for (size_t i = 0; i < 10; i++) {
+                auto e = lock.NewEntity();
+                e.Set<Transform>(lock, 1.0 * i, 0.0, 0.0);
+                if (i % 2 == 0) e.Set<Renderable>(lock, "entity" + std::to_string(i));
+                entities.emplace_back(e);
+            }
+            lock.Set<GlobalComponent>(5);
+        }
+        auto checkpoint = checkpointEcs.Checkpoint();
+        Assert(checkpoint.IsValid(), "Expected checkpoint to be valid");
+
+        Tecs::Entity added;
+        {
+            auto lock = checkpointEcs.StartTransaction<Tecs::AddRemove>();
+            for (auto &e : entities) {
+                e.Get<Transform>(lock).pos[1] = 10.0;
+            }
+            Tecs::Entity(entities[0]).Destroy(lock);
+            entities[1].Unset<Transform>(lock);
+            entities[3].Set<Renderable>(lock, "new");
+            for (size_t i = 0; i < TECS_ENTITY_ALLOCATION_BATCH_SIZE; i++) {
+                added = lock.NewEntity();
+                added.Set<Transform>(lock, 0.0, 0.0, 0.0);
+            }
+            lock.Unset<GlobalComponent>();
+        }
+        checkpointEcs.Restore(checkpoint);
+        {
+            auto lock = checkpointEcs.StartTransaction<Tecs::ReadAll>();
+            Assert(!added.Exists(lock), "Expected entity added after the checkpoint to be removed");
+            Assert(lock.EntitiesWith<Transform>().size() == 10, "Expected all transforms to be restored");
+            Assert(lock.EntitiesWith<Renderable>().size() == 5, "Expected all renderables to be restored");
+            for (size_t i = 0; i < entities.size(); i++) {
+                auto &e = entities[i];
+                Assert(e.Exists(lock), "Expected entity to be restored with its original id");
+                Assert(e.Get<Transform>(lock).pos[0] == 1.0 * i, "Expected transform to be restored");
+                Assert(e.Get<Transform>(lock).pos[1] == 0.0, "Expected transform to be restored");
+                Assert(e.Has<Renderable>(lock) == (i % 2 == 0), "Expected renderables to be restored");
+            }
+            Assert(lock.Has<GlobalComponent>(), "Expected global component to be restored");
+            Assert(lock.Get<GlobalComponent>().globalCounter == 5, "Expected global component to be restored");
+        }
+        {
+            // Only the written component type needs to be copied, and no AddRemove commit is made.
+            auto lock = checkpointEcs.StartTransaction<Tecs::Write<Transform>>();
+            entities[2].Get<Transform>(lock).pos[2] = 3.0;
+        }
+        checkpointEcs.Checkpoint(checkpoint);
+        {
+            auto lock = checkpointEcs.StartTransaction<Tecs::Write<Transform>>();
+            entities[2].Get<Transform>(lock).pos[2] = 4.0;
+        }
+        checkpointEcs.Restore(checkpoint);
+        {
+            auto lock = checkpointEcs.StartTransaction<Tecs::Read<Transform>>();
+            Assert(entities[2].Get<Transform>(lock).pos[2] == 3.0, "Expected updated checkpoint to be restored");
+        }
+        {
+            // Deferred writes don't increment the commit count, but must still be rolled back.
+            auto lock = checkpointEcs.StartTransaction<Tecs::WriteDeferred<Transform>>();
+            entities[2].Get<Transform>(lock).pos[2] = 5.0;
+        }
+        checkpointEcs.Restore(checkpoint);
+        checkpointEcs.Publish<Transform>();
+        {
+            auto lock = checkpointEcs.StartTransaction<Tecs::Read<Transform>>();
+            Assert(entities[2].Get<Transform>(lock).pos[2] == 3.0, "Expected deferred write to be rolled back");
+        }
+
+        // Generations are never rewound, so ids from after the checkpoint can't alias entities created after restoring.
+        checkpointEcs.Checkpoint(checkpoint);
+        Tecs::Entity first, second, reused;
+        {
+            auto lock = checkpointEcs.StartTransaction<Tecs::AddRemove>();
+            first = lock.NewEntity();
+            Tecs::Entity(entities[4]).Destroy(lock);
+        }
+        {
+            auto lock = checkpointEcs.StartTransaction<Tecs::AddRemove>();
+            Tecs::Entity(first).Destroy(lock);
+        }
+        {
+            auto lock = checkpointEcs.StartTransaction<Tecs::AddRemove>();
+            second = lock.NewEntity();
+            reused = lock.NewEntity();
+            Assert(second.index == entities[4].index, "Expected destroyed index to be reused");
+            Assert(reused.index == first.index, "Expected destroyed index to be reused");
+        }
+        checkpointEcs.Restore(checkpoint);
+        {
+            auto lock = checkpointEcs.StartTransaction<Tecs::AddRemove>();
+            Assert(!first.Exists(lock) && !second.Exists(lock), "Expected entities after the checkpoint to be removed");
+            Assert(!reused.Exists(lock), "Expected entities after the checkpoint to be removed");
+            Assert(!entities[4].Exists(lock), "Expected entity with a reused index to get a new generation");
+            Assert(entities[3].Exists(lock), "Expected entity to be restored with its original id");
+            size_t restoredCount = 0;
+            for (auto &e : lock.EntitiesWith<Transform>()) {
+                if (e.index != entities[4].index) continue;
+                Assert(e.generation > second.generation, "Expected restored generation past the reused one");
+                Assert(e.Get<Transform>(lock).pos[0] == 4.0, "Expected restored entity's components");
+                restoredCount++;
+            }
+            Assert(restoredCount == 1, "Expected entity with a reused index to be restored");
+
+            auto e = lock.NewEntity();
+            Assert(e.index == reused.index, "Expected free index to be reused");
+            Assert(e.generation > reused.generation, "Expected free index to get a new generation");
+            Assert(!reused.Exists(lock), "Expected old id not to alias the new entity");
+        }
+    }
+    {
+        Timer t("Test forking an ECS instance");
+        using ForkECS = Tecs::ECS<Transform, Renderable, GlobalComponent>;
+        ForkECS sourceEcs;
+
+        std::vector<Tecs::Entity> entities;
+        {
+            auto lock = sourceEcs.StartTransaction<Tecs::AddRemove>();
+            for (size_t i = 0; i < 10; i++) {
+                auto e = lock.NewEntity();
+                e.Set<Transform>(lock, 1.0 * i, 0.0, 0.0);
+                if (i % 2 == 0) e.Set<Renderable>(lock, "entity" + std::to_string(i));
+                entities.emplace_back(e);
+            }
+            Tecs::Entity(entities[9]).Destroy(lock);
+            lock.Set<GlobalComponent>(5);
+        }
+        auto fork = sourceEcs.Fork();
+        Tecs::Entity forkEntity;
+        {
+            auto lock = fork->StartTransaction<Tecs::AddRemove>();
+            Assert(lock.EntitiesWith<Transform>().size() == 9, "Expected forked transforms");
+            Assert(lock.EntitiesWith<Renderable>().size() == 5, "Expected forked renderables");
+            Assert(lock.Get<GlobalComponent>().globalCounter == 5, "Expected forked global component");
+            for (size_t i = 0; i < 9; i++) {
+                Assert(entities[i].Get<Transform>(lock).pos[0] == 1.0 * i, "Expected forked transform value");
+                entities[i].Get<Transform>(lock).pos[1] = 1.0;
+            }
+            entities[0].Unset<Renderable>(lock);
+            forkEntity = lock.NewEntity();
+            Assert(forkEntity.index == entities[9].index, "Expected forked free list to be rebuilt");
+            forkEntity.Set<Transform>(lock, 0.0, 0.0, 0.0);
+        }
+        {
+            auto lock = sourceEcs.StartTransaction<Tecs::ReadAll>();
+            Assert(!forkEntity.Exists(lock), "Expected fork entities not to exist in the source");
+            Assert(lock.EntitiesWith<Transform>().size() == 9, "Expected source transforms to be unchanged");
+            Assert(entities[0].Has<Renderable>(lock), "Expected source renderable to be unchanged");
+            for (size_t i = 0; i < 9; i++) {
+                Assert(entities[i].Get<Transform>(lock).pos[1] == 0.0, "Expected source transform to be unchanged");
+            }
+        }
+        {
+            auto lock = fork->StartTransaction<Tecs::Read<Transform>>();
+            Assert(lock.EntitiesWith<Transform>().size() == 10, "Expected fork changes to be committed");
+            Assert(entities[0].Get<Transform>(lock).pos[1] == 1.0, "Expected fork changes to be committed");
+        }
+
+        // Forks share the source's committed storage, so commits to the source must leave the fork's values untouched.
+        Tecs::Observer<ForkECS, Tecs::ComponentEvent<Renderable>> renderableObserver;
+        {
+            auto lock = sourceEcs.StartTransaction<Tecs::AddRemove>();
+            renderableObserver = lock.Watch<Tecs::ComponentEvent<Renderable>>();
+        }
+        auto sharedFork = sourceEcs.Fork();
+        {
+            auto sourceStats = sourceEcs.GetStats();
+            auto forkStats = sharedFork->GetStats();
+            Assert(forkStats.entities.validEntityCount == sourceStats.entities.validEntityCount,
+                "Expected forked entity count stat");
+            for (size_t i = 0; i < forkStats.components.size(); i++) {
+                Assert(forkStats.components[i].validEntityCount == sourceStats.components[i].validEntityCount,
+                    "Expected forked component count stat");
+            }
+        }
+        {
+            auto lock = sourceEcs.StartTransaction<Tecs::AddRemove>();
+            entities[2].Unset<Renderable>(lock);
+            entities[4].Get<Renderable>(lock).name = "source";
+            entities[3].Get<Transform>(lock).pos[2] = 3.0;
+        }
+        {
+            auto lock = sourceEcs.StartTransaction<Tecs::Write<Transform>>();
+            entities[5].Get<Transform>(lock).pos[2] = 5.0;
+        }
+        {
+            auto lock = sharedFork->StartTransaction<Tecs::ReadAll>();
+            Assert(entities[2].Get<Renderable>(lock).name == "entity2", "Expected shared removed value to be kept");
+            Assert(entities[4].Get<Renderable>(lock).name == "entity4", "Expected shared value to be unchanged");
+            Assert(entities[3].Get<Transform>(lock).pos[2] == 0.0, "Expected shared value to be unchanged");
+            Assert(entities[5].Get<Transform>(lock).pos[2] == 0.0, "Expected shared value to be unchanged");
+        }
+        {
+            auto lock = sourceEcs.StartTransaction<Tecs::Read<Transform, Renderable>>();
+            Tecs::ComponentEvent<Renderable> event;
+            Assert(renderableObserver.Poll(lock, event), "Expected a REMOVED event");
+            Assert(event.type == Tecs::EventType::REMOVED, "Expected component event type to be REMOVED");
+            Assert(event.component.name == "entity2", "Expected REMOVED event to contain the removed value");
+            Assert(!entities[2].Has<Renderable>(lock), "Expected source renderable to be removed");
+            Assert(entities[4].Get<Renderable>(lock).name == "source", "Expected source changes to be committed");
+            Assert(entities[3].Get<Transform>(lock).pos[2] == 3.0, "Expected source changes to be committed");
+            Assert(entities[5].Get<Transform>(lock).pos[2] == 5.0, "Expected source changes to be committed");
+            Assert(entities[6].Get<Transform>(lock).pos[0] == 6.0, "Expected source values to be copied back");
+        }
+        {
+            // The fork's write storage is filled in by its first writer.
+            auto lock = sharedFork->StartTransaction<Tecs::AddRemove>();
+            entities[8].Get<Renderable>(lock).name = "fork";
+            Assert(lock.NewEntity().index == entities[9].index, "Expected forked free list to be built");
+        }
+        {
+            auto lock = sharedFork->StartTransaction<Tecs::Read<Renderable>>();
+            Assert(entities[8].Get<Renderable>(lock).name == "fork", "Expected fork changes to be committed");
+            Assert(lock.EntitiesWith<Renderable>().size() == 5, "Expected shared renderables to be kept");
+        }
+    }
+    {
+        Timer t("Test transaction scratch arenas");
+        auto fillScratch = [](auto &lock) {
+            auto &scratch = lock.Scratch();
+            std::pmr::vector<Tecs::Entity> entities(&scratch);
+            for (auto &e : lock.template EntitiesWith<Transform>()) {
+                entities.emplace_back(e);
+            }
+            Assert(entities.size() == lock.template EntitiesWith<Transform>().size(), "Expected entities to be copied");
+
+            // Allocations larger than a block, and over-aligned allocations, are also supported.
+            std::pmr::vector<char> large(TECS_SCRATCH_BLOCK_SIZE * 2, 'a', &scratch);
+            auto aligned = scratch.allocate(16, 256);
+            Assert(((uintptr_t)aligned & 255) == 0, "Expected scratch allocation to be aligned");
+        };
+        size_t capacity;
+        {
+            auto lock = ecs.StartTransaction<Tecs::Read<Transform>>();
+            Assert(&lock.Scratch() == &lock.Scratch(), "Expected the same arena for the whole transaction");
+            fillScratch(lock);
+            Assert(lock.Scratch().BytesAllocated() > TECS_SCRATCH_BLOCK_SIZE * 2, "Expected large allocation");
+            capacity = lock.Scratch().Capacity();
+        }
+        {
+            auto lock = ecs.StartTransaction<Tecs::Read<Transform>>();
+            auto &scratch = lock.Scratch();
+            Assert(scratch.BytesAllocated() == 0, "Expected arena to be reset when the transaction ended");
+            Assert(scratch.Capacity() == capacity, "Expected pooled arena to keep its memory");
+            fillScratch(lock);
+            Assert(scratch.Capacity() == capacity, "Expected recycled memory to fit the same allocations");
+        }
+    }
+    {
+        Timer t("Test iterating entity views as contiguous spans");
+        Tecs::ECS<Transform> spanEcs;
+        {
+            auto lock = spanEcs.StartTransaction<Tecs::AddRemove>();
+            for (size_t i = 0; i < 10; i++) {
+                lock.NewEntity().Set<Transform>(lock, 1.0 * i, 0.0, 0.0);
+            }
+        }
+        auto lock = spanEcs.StartTransaction<Tecs::Read<Transform>>();
+        auto &entities = lock.EntitiesWith<Transform>();
+        auto span = entities.span();
+        Assert(span.size() == entities.size(), "Expected span to cover the whole view");
+        Assert(std::equal(span.begin(), span.end(), entities.begin()), "Expected span to match the view");
+
+        size_t count = 0;
+        std::for_each(span.begin(), span.end(), [&](const Tecs::Entity &e) {
+            if (e.Has<Transform>(lock)) count++;
+        });
+        Assert(count == entities.size(), "Expected all span entities to have a transform");
+
+        auto subview = entities.subview(2, 3);
+        Assert(subview.data() == entities.data() + 2, "Expected subview data to be offset");
+        Assert(subview.span().size() == 3, "Expected subview span to be bounded");
+        Assert(subview.span()[0] == *(entities.begin() + 2), "Expected subview span to start at its offset");
+        Assert(Tecs::EntityView().span().empty(), "Expected an empty view to have an empty span");
+    }
+    {
+        Timer t("Test querying entities changed since a commit");
+        using ChangeECS = Tecs::ECS<Transform, Tick>;
+        ChangeECS changeEcs;
+
+        std::vector<Tecs::Entity> entities;
+        {
+            auto lock = changeEcs.StartTransaction<Tecs::AddRemove>();
+            for (size_t i = 0; i < 10; i++) {
+                auto e = lock.NewEntity();
+                e.Set<Tick>(lock, i);
+                entities.emplace_back(e);
+            }
+        }
+        size_t firstTick;
+        {
+            auto lock = changeEcs.StartTransaction<Tecs::Read<Tick>>();
+            Assert(lock.EntitiesChangedSince<Tick>(0).size() == 10, "Expected all new entities to be changed");
+            firstTick = lock.GetCommitTick<Tick>();
+            Assert(lock.EntitiesChangedSince<Tick>(firstTick).empty(), "Expected no changes since latest commit");
+        }
+        {
+            auto lock = changeEcs.StartTransaction<Tecs::Write<Tick>>();
+            entities[5].Get<Tick>(lock).value = 50;
+            entities[2].Set<Tick>(lock, 20);
+            entities[3].Get<const Tick>(lock);
+        }
+        size_t secondTick;
+        {
+            auto lock = changeEcs.StartTransaction<Tecs::Read<Tick>>();
+            auto changed = lock.EntitiesChangedSince<Tick>(firstTick);
+            Assert(changed.size() == 2, "Expected only written entities to be changed");
+            Assert(changed[0] == entities[2] && changed[1] == entities[5], "Expected changes in index order");
+            secondTick = lock.GetCommitTick<Tick>();
+            Assert(secondTick > firstTick, "Expected commit tick to advance");
+        }
+        {
+            // Transactions that don't write to Tick don't advance its commit tick.
+            auto lock = changeEcs.StartTransaction<Tecs::Write<Transform>>();
+        }
+        Tecs::Entity added;
+        {
+            auto lock = changeEcs.StartTransaction<Tecs::AddRemove>();
+            Assert(lock.GetCommitTick<Tick>() == secondTick, "Expected commit tick to be unchanged");
+            added = lock.NewEntity();
+            added.Set<Tick>(lock, 100);
+            lock.GetMany<Tick>(std::vector<Tecs::Entity>{entities[7]}, [](const Tecs::Entity &, Tick &tick) {
+                tick.value = 70;
+            });
+        }
+        {
+            auto lock = changeEcs.StartTransaction<Tecs::Read<Tick>>();
+            auto changed = lock.EntitiesChangedSince<Tick>(secondTick);
+            Assert(changed.size() == 2, "Expected added and written entities to be changed");
+            Assert(changed[0] == entities[7] && changed[1] == added, "Expected changes in index order");
+            Assert(lock.EntitiesChangedSince<Tick>(firstTick).size() == 4, "Expected changes to accumulate");
+        }
+
+        // Forks keep the source's commit and change ticks.
+        auto fork = changeEcs.Fork();
+        size_t forkTick;
+        {
+            auto lock = fork->StartTransaction<Tecs::Read<Tick>>();
+            auto changed = lock.EntitiesChangedSince<Tick>(secondTick);
+            Assert(changed.size() == 2, "Expected forked entities to keep their change ticks");
+            Assert(changed[0] == entities[7] && changed[1] == added, "Expected forked changes in index order");
+            Assert(lock.EntitiesChangedSince<Tick>(firstTick).size() == 4, "Expected forked changes to accumulate");
+            forkTick = lock.GetCommitTick<Tick>();
+            Assert(forkTick > secondTick, "Expected forked commit tick to continue from the source");
+        }
+        {
+            auto lock = fork->StartTransaction<Tecs::Write<Tick>>();
+            entities[1].Get<Tick>(lock).value = 10;
+        }
+        {
+            auto lock = fork->StartTransaction<Tecs::Read<Tick>>();
+            auto changed = lock.EntitiesChangedSince<Tick>(forkTick);
+            Assert(changed.size() == 1 && changed[0] == entities[1], "Expected only fork writes to be changed");
+            Assert(lock.EntitiesChangedSince<Tick>(secondTick).size() == 3, "Expected fork changes to accumulate");
+        }
+    }
+    {
+        Timer t("Test instantiating prefab entities");
+        using PrefabECS = Tecs::ECS<Transform, Renderable, Script, GlobalComponent>;
+        PrefabECS prefabEcs;
+        Tecs::Observer<PrefabECS, Tecs::EntityEvent> entityObserver;
+        Tecs::Observer<PrefabECS, Tecs::ComponentEvent<Renderable>> renderableObserver;
+        {
+            auto lock = prefabEcs.StartTransaction<Tecs::AddRemove>();
+            entityObserver = lock.Watch<Tecs::EntityEvent>();
+            renderableObserver = lock.Watch<Tecs::ComponentEvent<Renderable>>();
+        }
+
+        std::vector<Tecs::Entity> instances;
+        {
+            auto lock = prefabEcs.StartTransaction<Tecs::AddRemove>();
+            auto prefab = lock.NewEntity();
+            prefab.Set<Transform>(lock, 1.0, 2.0, 3.0);
+            prefab.Set<Renderable>(lock, "npc");
+            instances = lock.Instantiate(prefab, 1000);
+            Assert(instances.size() == 1000, "Expected all instances to be created");
+            for (size_t i = 1; i < instances.size(); i++) {
+                Assert(instances[i].index == instances[0].index + i, "Expected a contiguous range of entities");
+            }
+            Assert(instances[0].Get<Renderable>(lock).name == "npc", "Expected instances to be visible");
+            prefab.Destroy(lock);
+        }
+        {
+            auto lock = prefabEcs.StartTransaction<Tecs::Read<Transform, Renderable, Script>>();
+            Assert(lock.EntitiesWith<Transform>().size() == 1000, "Expected instances to have transforms");
+            Assert(lock.EntitiesWith<Renderable>().size() == 1000, "Expected instances to have renderables");
+            Assert(lock.EntitiesWith<Script>().empty(), "Expected instances to only have prefab components");
+            for (auto &e : instances) {
+                Assert(e.Get<Transform>(lock).pos[2] == 3.0, "Expected instance transform to be copied");
+                Assert(e.Get<Renderable>(lock).name == "npc", "Expected instance renderable to be copied");
+            }
+        }
+        {
+            auto lock = prefabEcs.StartTransaction<Tecs::AddRemove>();
+            Tecs::EntityEvent entityEvent;
+            size_t added = 0;
+            while (entityObserver.Poll(lock, entityEvent)) {
+                if (entityEvent.type == Tecs::EventType::ADDED) added++;
+            }
+            Assert(added == 1000, "Expected ADDED events for all instances");
+            Tecs::ComponentEvent<Renderable> renderableEvent;
+            added = 0;
+            while (renderableObserver.Poll(lock, renderableEvent)) {
+                if (renderableEvent.type == Tecs::EventType::ADDED) added++;
+            }
+            Assert(added == 1000, "Expected ADDED events for all instances");
+            entityObserver.Stop(lock);
+            renderableObserver.Stop(lock);
+        }
+
+        // Prefabs can also be instantiated from a separate instance.
+        PrefabECS libraryEcs;
+        Tecs::Entity libraryPrefab;
+        {
+            auto lock = libraryEcs.StartTransaction<Tecs::AddRemove>();
+            libraryPrefab = lock.NewEntity();
+            libraryPrefab.Set<Script>(lock, std::initializer_list<uint32_t>{1, 2, 3});
+        }
+        {
+            auto prefabLock = libraryEcs.StartTransaction<Tecs::ReadAll>();
+            auto lock = prefabEcs.StartTransaction<Tecs::AddRemove>();
+            auto scripted = lock.Instantiate(prefabLock, libraryPrefab, 10);
+            Assert(scripted.size() == 10, "Expected all instances to be created");
+            Assert(scripted[9].Get<Script>(lock).data.size() == 3, "Expected library prefab to be copied");
+            Assert(!scripted[0].Has<Transform>(lock), "Expected instances to only have prefab components");
+        }
+    }
+    {
+        Timer t("Test aborting transactions");
+        using AbortECS = Tecs::ECS<Transform, Renderable, Tick, GlobalComponent>;
+        AbortECS abortEcs;
+
+        std::vector<Tecs::Entity> entities;
+        {
+            auto lock = abortEcs.StartTransaction<Tecs::AddRemove>();
+            for (size_t i = 0; i < 100; i++) {
+                auto e = lock.NewEntity();
+                e.Set<Transform>(lock, 1.0 * i, 0.0, 0.0);
+                e.Set<Tick>(lock, i);
+                entities.emplace_back(e);
+            }
+            lock.Set<GlobalComponent>(1);
+        }
+        size_t commitTick;
+        {
+            auto lock = abortEcs.StartTransaction<Tecs::Write<Transform, Tick>>();
+            commitTick = lock.GetCommitTick<Tick>();
+            entities[3].Get<Transform>(lock).pos[0] = -1.0;
+            entities[4].Set<Tick>(lock, 1000);
+            lock.Abort();
+            Assert(entities[3].Get<const Transform>(lock).pos[0] == 3.0, "Expected write to be discarded");
+            Assert(entities[4].Get<const Tick>(lock).value == 4, "Expected write to be discarded");
+
+            // Writes made after aborting are tracked again, and can also be aborted.
+            for (size_t i = 0; i < 50; i++) {
+                entities[4].Get<Tick>(lock).value++;
+            }
+            entities[5].Set<Tick>(lock, 1000);
+            lock.Abort();
+            Assert(entities[4].Get<const Tick>(lock).value == 4, "Expected repeated writes to be discarded");
+            Assert(entities[5].Get<const Tick>(lock).value == 5, "Expected write to be discarded");
+
+            // Writes made after aborting are committed.
+            entities[5].Get<Transform>(lock).pos[1] = 5.0;
+        }
+        {
+            auto lock = abortEcs.StartTransaction<Tecs::Write<Transform, Tick>>();
+            Assert(lock.GetCommitTick<Tick>() == commitTick, "Expected aborted component not to be committed");
+            Assert(entities[3].Get<const Transform>(lock).pos[0] == 3.0, "Expected write to be discarded");
+            Assert(entities[5].Get<const Transform>(lock).pos[1] == 5.0, "Expected write after abort to commit");
+
+            // Writing most of the storage resets the whole buffer instead.
+            for (auto &e : entities) {
+                e.Get<Transform>(lock).pos[2] = 10.0;
+            }
+            lock.Abort();
+            for (auto &e : entities) {
+                Assert(e.Get<const Transform>(lock).pos[2] == 0.0, "Expected all writes to be discarded");
+            }
+        }
+        Tecs::Entity added;
+        {
+            auto lock = abortEcs.StartTransaction<Tecs::AddRemove>();
+            added = lock.NewEntity();
+            added.Set<Renderable>(lock, "added");
+            entities[6].Set<Renderable>(lock, "six");
+            entities[7].Unset<Tick>(lock);
+            Tecs::Entity(entities[8]).Destroy(lock);
+            lock.Set<GlobalComponent>(2);
+            lock.Abort();
+
+            Assert(!added.Exists(lock), "Expected new entity to be discarded");
+            Assert(!entities[6].Has<Renderable>(lock), "Expected new component to be discarded");
+            Assert(entities[7].Get<Tick>(lock).value == 7, "Expected removed component to be restored");
+            Assert(entities[8].Exists(lock), "Expected destroyed entity to be restored");
+            Assert(lock.EntitiesWith<Renderable>().empty(), "Expected valid entity lists to be restored");
+            Assert(lock.Entities().size() == 100, "Expected valid entity lists to be restored");
+            Assert(lock.Get<GlobalComponent>().globalCounter == 1, "Expected global component to be restored");
+            Assert(lock.NewEntity() == added, "Expected the free list to be restored");
+        }
+        {
+            auto lock = abortEcs.StartTransaction<Tecs::ReadAll>();
+            Assert(lock.Entities().size() == 101, "Expected only the entity created after aborting to be committed");
+            Assert(lock.EntitiesWith<Tick>().size() == 100, "Expected removed component to be restored");
+            Assert(lock.EntitiesWith<Renderable>().empty(), "Expected added components to be discarded");
+        }
+        {
+            // Entities taken from the free list are returned to it in order.
+            auto lock = abortEcs.StartTransaction<Tecs::AddRemove>();
+            auto first = lock.NewEntity();
+            auto second = lock.NewEntity();
+            first.Set<Renderable>(lock, "first");
+            Tecs::Entity(entities[10]).Destroy(lock);
+            lock.Abort();
+
+            Assert(!first.Exists(lock) && !second.Exists(lock), "Expected new entities to be discarded");
+            Assert(entities[10].Get<Tick>(lock).value == 10, "Expected destroyed entity to be restored");
+            Assert(lock.Entities().size() == 101, "Expected valid entity lists to be restored");
+            Assert(lock.NewEntity() == first, "Expected the free list to be restored");
+            Assert(lock.NewEntity() == second, "Expected the free list to be restored");
+            lock.Abort();
+        }
+        {
+            // Valid entity indexes must be restored along with the valid entity lists.
+            auto lock = abortEcs.StartTransaction<Tecs::AddRemove>();
+            entities[9].Unset<Tick>(lock);
+            entities[9].Set<Tick>(lock, 90);
+            lock.Abort();
+            entities[9].Unset<Tick>(lock);
+
+            // Removed entities are cleared from the valid entity list, and compacted when committed.
+            size_t tickCount = 0;
+            for (auto &e : lock.EntitiesWith<Tick>()) {
+                if (!e) continue;
+                Assert(e != entities[9], "Expected removed component not to be valid");
+                Assert(e.Has<Tick>(lock), "Expected valid entity list to only contain entities with the component");
+                tickCount++;
+            }
+            Assert(tickCount == 99, "Expected one component to be removed");
+        }
+        {
+            auto lock = abortEcs.StartTransaction<Tecs::ReadAll>();
+            Assert(lock.EntitiesWith<Tick>().size() == 99, "Expected one component to be removed");
+            Assert(!entities[9].Has<Tick>(lock), "Expected removed component to be committed");
+            for (auto &e : lock.EntitiesWith<Tick>()) {
+                Assert(e != entities[9] && e.Has<Tick>(lock), "Expected valid entity list to match components");
+            }
+        }
+#ifndef TECS_UNCHECKED_MODE
+        {
+            auto lock = abortEcs.StartTransaction<Tecs::WriteDeferred<Transform>>();
+            entities[0].Get<Transform>(lock).pos[0] = 2.0;
+        }
+        try {
+            auto lock = abortEcs.StartTransaction<Tecs::Write<Transform>>();
+            entities[1].Get<Transform>(lock).pos[0] = 2.0;
+            lock.Abort();
+            Assert(false, "Aborting writes to a component with unpublished writes should fail");
+        } catch (std::runtime_error &e) {
+            std::string msg = e.what();
+            Assert(msg.rfind("Can't abort writes to a component with unpublished deferred writes", 0) == 0,
+                "Received wrong runtime_error: " + msg);
+        }
+        additionalTransactionCount += 2;
+#endif
+    }
+    {
+        Timer t("Test components sharing a lock group");
+        using GroupECS = Tecs::ECS<Transform, Velocity, Renderable>;
+        GroupECS groupEcs;
+        Tecs::Entity e;
+        {
+            auto lock = groupEcs.StartTransaction<Tecs::AddRemove>();
+            e = lock.NewEntity();
+            e.Set<Transform>(lock, 1.0, 2.0, 3.0);
+            e.Set<Velocity>(lock, 0.0, 0.0, 0.0);
+            e.Set<Renderable>(lock, "grouped");
+        }
+        {
+            auto lock = groupEcs.StartTransaction<Tecs::Write<Velocity>>();
+            e.Get<Velocity>(lock).v[0] = 1.0;
+        }
+        {
+            auto lock = groupEcs.StartTransaction<Tecs::Read<Transform, Velocity>>();
+            Assert(e.Get<Velocity>(lock).v[0] == 1.0, "Expected grouped component write to be committed");
+            Assert(e.Get<Transform>(lock).pos[0] == 1.0, "Expected other grouped component to be unchanged");
+        }
+
+        std::future<void> writer;
+        {
+            // Reading one member of a group holds the group's lock, so commits to other members wait for it.
+            auto lock = groupEcs.StartTransaction<Tecs::Read<Transform>>();
+            writer = std::async(std::launch::async, [&groupEcs, e] {
+                auto writeLock = groupEcs.StartTransaction<Tecs::Write<Velocity>>();
+                e.Get<Velocity>(writeLock).v[0] = 2.0;
+            });
+            Assert(writer.wait_for(std::chrono::milliseconds(20)) == std::future_status::timeout,
+                "Expected grouped commit to wait for the group's readers");
+        }
+        writer.wait();
+
+        std::future<void> blocked;
+        {
+            auto lock = groupEcs.StartTransaction<Tecs::Write<Velocity>>();
+            auto other = std::async(std::launch::async, [&groupEcs] {
+                auto otherLock = groupEcs.StartTransaction<Tecs::Write<Renderable>>();
+            });
+            Assert(other.wait_for(std::chrono::seconds(10)) == std::future_status::ready,
+                "Expected components outside the group not to block");
+            blocked = std::async(std::launch::async, [&groupEcs] {
+                auto blockedLock = groupEcs.StartTransaction<Tecs::Write<Transform>>();
+            });
+            Assert(blocked.wait_for(std::chrono::milliseconds(20)) == std::future_status::timeout,
+                "Expected writers to other members of the group to block");
+        }
+        blocked.wait();
+        {
+            auto lock = groupEcs.StartTransaction<Tecs::Read<Velocity>>();
+            Assert(e.Get<Velocity>(lock).v[0] == 2.0, "Expected grouped component write to be committed");
+        }
+        {
+            // Commits to any member of a group are pending for readers of every other member.
+            auto readLock = groupEcs.StartTransaction<Tecs::Read<Velocity>>();
+            Assert(!readLock.CommitPending<Velocity>(), "Expected no commit to be pending");
+
+            auto writer = std::async(std::launch::async, [&groupEcs, e] {
+                auto writeLock = groupEcs.StartTransaction<Tecs::Write<Transform>>();
+                e.Get<Transform>(writeLock).pos[0] = 4.0;
+            });
+            while (!readLock.CommitPending<Velocity>()) {
+                std::this_thread::yield();
+            }
+            readLock.Yield();
+            writer.get();
+        }
+        {
+            auto lock = groupEcs.StartTransaction<Tecs::Read<Transform>>();
+            Assert(e.Get<Transform>(lock).pos[0] == 4.0, "Expected grouped commit to complete while yielding");
+        }
+
+        auto stats = groupEcs.GetStats();
+        Assert(stats.components[GroupECS::GetComponentIndex<Transform>()].writeLockWaits > 0,
+            "Expected lock waits to be recorded on the group leader");
+        Assert(stats.components[GroupECS::GetComponentIndex<Velocity>()].writeLockWaits == 0,
+            "Expected no lock waits to be recorded on group members");
+        additionalTransactionCount += 12;
+    }
+    {
+        Timer t("Test reading ECS stats");
+        ECS statsEcs;
+        Tecs::Observer<ECS, Tecs::ComponentEvent<Transform>> statsObserver;
+        {
+            auto lock = statsEcs.StartTransaction<Tecs::AddRemove>();
+            statsObserver = lock.Watch<Tecs::ComponentEvent<Transform>>();
+            for (size_t i = 0; i < 100; i++) {
+                auto e = lock.NewEntity();
+                e.Set<Transform>(lock, 1.0, 2.0, 3.0);
+                if (i % 2 == 0) e.Set<Renderable>(lock, "entity" + std::to_string(i));
+            }
+            lock.Set<GlobalComponent>(1);
+        }
+        auto stats = statsEcs.GetStats();
+        auto &transformStats = stats.components[ECS::GetComponentIndex<Transform>()];
+        Assert(stats.components.size() == ECS::GetComponentCount(), "Expected stats for each component type");
+        Assert(stats.entities.validEntityCount == 100, "Expected stats to count all entities");
+        Assert(stats.entities.commitCount == 1, "Expected stats to count one entity commit");
+        Assert(transformStats.name == ECS::GetComponentName<Transform>(), "Expected stats to use component names");
+        Assert(transformStats.validEntityCount == 100, "Expected stats to count Transform entities");
+        Assert(transformStats.observerBacklog == 100, "Expected stats to count unpolled Transform events");
+        Assert(stats.components[ECS::GetComponentIndex<Renderable>()].validEntityCount == 50,
+            "Expected stats to count Renderable entities");
+        Assert(stats.components[ECS::GetComponentIndex<Script>()].validEntityCount == 0,
+            "Expected stats to count Script entities");
+        Assert(stats.components[ECS::GetComponentIndex<GlobalComponent>()].global,
+            "Expected stats to flag global components");
+        Assert(stats.components[ECS::GetComponentIndex<GlobalComponent>()].validEntityCount == 1,
+            "Expected stats to count the global component");
+        Assert(stats.ToJson().find("\"validEntityCount\":100,\"commitCount\":1,") != std::string::npos,
+            "Expected stats to be written as JSON");
+
+        {
+            auto lock = statsEcs.StartTransaction<Tecs::Write<Transform>>();
+            lock.EntitiesWith<Transform>()[0].Get<Transform>(lock).pos[0] = 4.0;
+        }
+        stats = statsEcs.GetStats();
+        Assert(stats.components[ECS::GetComponentIndex<Transform>()].commitCount == 2,
+            "Expected stats to count two Transform commits");
+        Assert(stats.components[ECS::GetComponentIndex<Transform>()].lastCommitCopies == 100,
+            "Expected stats to count values copied by the last commit");
+        Assert(stats.entities.commitCount == 1, "Expected stats to count one entity commit");
+
+        std::thread waitingThread;
+        {
+            // Stats can be read while another thread is waiting on a lock held by this one.
+            auto lock = statsEcs.StartTransaction<Tecs::Write<Transform>>();
+            waitingThread = std::thread([&statsEcs] {
+                auto lock = statsEcs.StartTransaction<Tecs::Write<Transform>>();
+            });
+            while (statsEcs.GetStats().components[ECS::GetComponentIndex<Transform>()].writeLockWaits == 0) {
+                std::this_thread::yield();
+            }
+        }
+        waitingThread.join();
+        additionalTransactionCount += 4;
+    }
+#ifndef _WIN32
+    {
+        Timer t("Test publishing components to shared memory");
+        std::string name = "/tecs-test-" + std::to_string(getpid());
+        Tecs::Entity e;
+        {
+            auto lock = ecs.StartTransaction<Tecs::AddRemove>();
+            e = lock.NewEntity();
+            e.Set<Transform>(lock, 3.0, 4.0, 5.0);
+        }
+        auto publisher = Tecs::SharedMemoryMirror<Transform>::Create(name, 2 * ENTITY_COUNT);
+        {
+            auto lock = ecs.StartTransaction<Tecs::Read<Transform>>();
+            Assert(publisher.TryPublish(lock), "Expected shared memory to be published");
+        }
+
+        // Open a second mapping of the segment, as another process would
+        auto reader = Tecs::SharedMemoryMirror<Transform>::Open(name);
+        Assert(reader.Capacity() == 2 * ENTITY_COUNT, "Expected shared memory capacity to match");
+        {
+            auto readLock = reader.StartRead<Transform>();
+            Assert(readLock.PublishCount() == 1, "Expected shared memory to be published once");
+            Assert(readLock.Exists(e), "Expected entity to exist in shared memory");
+            Assert(readLock.Has<Transform>(e), "Expected entity to have a Transform in shared memory");
+            Assert(readLock.Get<Transform>(e).pos[1] == 4.0, "Expected shared memory Transform to match");
+            Assert(std::find(readLock.Entities().begin(), readLock.Entities().end(), e) != readLock.Entities().end(),
+                "Expected entity to be in the shared memory entity list");
+        }
+        {
+            auto lock = ecs.StartTransaction<Tecs::AddRemove>();
+            e.Destroy(lock);
+            Assert(publisher.TryPublish(lock), "Expected shared memory to be published");
+        }
+        {
+            auto readLock = reader.StartRead<Transform>();
+            Assert(readLock.PublishCount() == 2, "Expected shared memory to be published twice");
+            Assert(!readLock.Exists(e), "Expected entity to be removed from shared memory");
+            Assert(!readLock.Has<Transform>(e), "Expected entity to not have a Transform in shared memory");
+        }
+        {
+            // Publishing never waits on readers, even if they hold their locks indefinitely
+            auto oldReadLock = reader.StartRead<Transform>();
+            {
+                auto lock = ecs.StartTransaction<Tecs::AddRemove>();
+                e = lock.NewEntity();
+                e.Set<Transform>(lock, 6.0, 7.0, 8.0);
+                Assert(publisher.TryPublish(lock), "Expected publish to use the buffer without readers");
+            }
+            Assert(oldReadLock.PublishCount() == 2, "Expected existing reader to keep its snapshot");
+            Assert(!oldReadLock.Exists(e), "Expected existing reader to not see the new entity");
+
+            auto newReadLock = reader.StartRead<Transform>();
+            Assert(newReadLock.PublishCount() == 3, "Expected new reader to see the latest publish");
+            Assert(newReadLock.Get<Transform>(e).pos[1] == 7.0, "Expected new reader to see the new entity");
+            {
+                auto lock = ecs.StartTransaction<Tecs::Read<Transform>>();
+                Assert(!publisher.TryPublish(lock), "Expected publish to be skipped while both buffers are read");
+            }
+            Assert(newReadLock.PublishCount() == 3, "Expected skipped publish to leave readers unchanged");
+        }
+        {
+            auto lock = ecs.StartTransaction<Tecs::Read<Transform>>();
+            Assert(publisher.TryPublish(lock), "Expected publish to succeed once readers unlock");
+        }
+        {
+            auto readLock = reader.StartRead<Transform>();
+            Assert(readLock.PublishCount() == 4, "Expected shared memory to be published four times");
+            Assert(readLock.Get<Transform>(e).pos[2] == 8.0, "Expected shared memory Transform to match");
+        }
+    }
+    {
+        Timer t("Test serving stats with an inspector");
+        std::string path = "/tmp/tecs-test-" + std::to_string(getpid()) + ".sock";
+        {
+            Tecs::Inspector inspector(ecs, path);
+            auto json = Tecs::Inspector::Query(path);
+            Assert(json.rfind("{\"entities\":{\"name\":\"Entities\"", 0) == 0, "Expected inspector to reply with JSON");
+            Assert(json.find("\"name\":\"" + ECS::GetComponentName<Transform>() + "\"") != std::string::npos,
+                "Expected inspector JSON to contain Transform stats");
+            auto text = Tecs::Inspector::Query(path, "text");
+            Assert(text.rfind("name\tglobal\t", 0) == 0, "Expected inspector to reply with text");
+            Assert(text == ecs.GetStats().ToString(), "Expected inspector text to match stats");
+        }
+        Assert(access(path.c_str(), F_OK) != 0, "Expected inspector socket to be removed");
+    }
+#endif
     {
         Timer t("Test total transaction count via transaction id");
         {
             auto readLock = ecs.StartTransaction<>();
             std::cout << "Total test transactions: " << readLock.GetTransactionId() << std::endl;
-            Assert(readLock.GetTransactionId() == 325 + additionalTransactionCount,
-                "Expected transaction id to be 325 + " + std::to_string(additionalTransactionCount));
+            Assert(readLock.GetTransactionId() == 452 + additionalTransactionCount,
+                "Expected transaction id to be 452 + " + std::to_string(additionalTransactionCount));
         }
     }
 